@@ -0,0 +1,221 @@
+#!/usr/bin/env python
+#*******************************************************************************
+#                                                                              *
+#  This file is part of Verificarlo.                                           *
+#                                                                              *
+#  Copyright (c) 2015-2016                                                     *
+#     Universite de Versailles St-Quentin-en-Yvelines                          *
+#     CMLA, Ecole Normale Superieure de Cachan                                 *
+#                                                                              *
+#  Verificarlo is free software: you can redistribute it and/or modify         *
+#  it under the terms of the GNU General Public License as published by        *
+#  the Free Software Foundation, either version 3 of the License, or           *
+#  (at your option) any later version.                                         *
+#                                                                              *
+#  Verificarlo is distributed in the hope that it will be useful,              *
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+#  GNU General Public License for more details.                                *
+#                                                                              *
+#  You should have received a copy of the GNU General Public License           *
+#  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+#                                                                              *
+#*******************************************************************************
+
+from __future__ import print_function
+import argparse
+import math
+import multiprocessing
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+from multiprocessing.pool import ThreadPool
+
+# Localizes the functions of a program responsible for the loss of
+# significant digits of its outputs. A configuration is a set of
+# instrumented functions, selected at runtime with a VERIFICARLO_SCOPE
+# file: the program is built once and every configuration is a small
+# Monte Carlo campaign of the same binary.
+#
+# The search is the delta debugging algorithm ddmin (Zeller and Hildebrandt)
+# applied to the instrumented functions: it returns a set of functions
+# which loses digits when it is the only one instrumented, and from which
+# no function can be removed alone. The samples of the subsets and
+# complements of each step are run concurrently.
+
+NUMBER = re.compile(r'[-+]?(?:(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?|\binf\b|\bnan\b)', re.IGNORECASE)
+
+def error(msg):
+    print(sys.argv[0] + ': ' + msg, file=sys.stderr)
+    sys.exit(1)
+
+def read_functions(path):
+    """ Returns the function names of a --functions-file, in order """
+    functions = []
+    for line in open(path):
+        name = line.strip()
+        if name and not name.startswith('#') and name not in functions:
+            functions.append(name)
+    return functions
+
+def program_functions(program):
+    """ Returns the functions defined in the symbol table of program """
+    functions = []
+    for line in subprocess.check_output(['nm', '--defined-only', program]).decode().splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[1] in 'Tt' and fields[2] not in functions:
+            functions.append(fields[2])
+    return functions
+
+def significant_digits(values):
+    """ Significant digits s = -log10(|std / mean|) of the samples of a number """
+    n = len(values)
+    mean = sum(values) / n
+    if any(math.isnan(v) or math.isinf(v) for v in values):
+        return 0.0 if len(set(values)) > 1 else float('inf')
+    std = math.sqrt(sum((v - mean) ** 2 for v in values) / (n - 1))
+    if std == 0:
+        return float('inf')
+    if mean == 0:
+        return 0.0
+    return max(0.0, -math.log10(abs(std / mean)))
+
+class Localizer(object):
+    def __init__(self, args):
+        self.args = args
+        if args.functions:
+            self.functions = read_functions(args.functions)
+        else:
+            self.functions = program_functions(args.command[0])
+        self.workdir = tempfile.mkdtemp(prefix='vfc-localize.')
+        self.digits = {}
+        self.runs = 0
+
+    def run(self, task):
+        """ Runs one sample of a configuration, returns the numbers printed
+        or None if the program fails """
+        index, sample = task
+        env = dict(os.environ)
+        env['VERIFICARLO_MCAMODE'] = self.args.mode
+        env['VERIFICARLO_SCOPE'] = os.path.join(self.workdir, 'scope-{0}'.format(index))
+        output = os.path.join(self.workdir, 'run-{0}-{1}.out'.format(index, sample))
+        with open(output, 'w') as out:
+            status = subprocess.call(self.args.command, stdout=out, env=env)
+        if status != 0:
+            return None
+        return [float(x) for x in NUMBER.findall(open(output).read())]
+
+    def campaign(self, configurations):
+        """ Returns the lowest significant digits of the outputs of each
+        configuration, the samples of every configuration run concurrently """
+        keys = [frozenset(c) for c in configurations]
+        todo = []
+        for key, functions in zip(keys, configurations):
+            if key in self.digits or key in [k for k, _ in todo]:
+                continue
+            index = len(self.digits) + len(todo)
+            with open(os.path.join(self.workdir, 'scope-{0}'.format(index)), 'w') as f:
+                for name in functions:
+                    print(name, file=f)
+            todo.append((key, index))
+
+        tasks = [(index, sample) for _, index in todo for sample in range(self.args.samples)]
+        outputs = self.pool.map(self.run, tasks)
+        self.runs += len(tasks)
+
+        for i, (key, index) in enumerate(todo):
+            samples = outputs[i * self.args.samples:(i + 1) * self.args.samples]
+            if any(s is None for s in samples) or len(set(len(s) for s in samples)) != 1:
+                digits = 0.0
+            else:
+                digits = min([significant_digits(v) for v in zip(*samples)] or [float('inf')])
+            self.digits[key] = digits
+            if self.args.verbose:
+                print('{0:6.2f} digits with {1} functions: {2}'.format(
+                    digits, len(key), ' '.join(sorted(key))), file=sys.stderr)
+        return [self.digits[key] for key in keys]
+
+    def unstable(self, configurations):
+        return [d < self.args.digits for d in self.campaign(configurations)]
+
+    def search(self):
+        """ Returns a 1-minimal list of functions losing digits """
+        self.pool = ThreadPool(self.args.jobs)
+        functions = list(self.functions)
+        if not self.unstable([functions])[0]:
+            error('the outputs keep {0} digits with every function instrumented'.format(
+                self.args.digits))
+
+        n = 2
+        while len(functions) >= 2:
+            n = min(n, len(functions))
+            size = len(functions) / float(n)
+            chunks = [functions[int(i * size):int((i + 1) * size)] for i in range(n)]
+            complements = [[f for f in functions if f not in c] for c in chunks] if n > 2 else []
+            failed = self.unstable(chunks + complements)
+
+            subsets = [c for c, u in zip(chunks, failed) if u]
+            supersets = [c for c, u in zip(complements, failed[len(chunks):]) if u]
+            if subsets:
+                functions, n = subsets[0], 2
+            elif supersets:
+                functions, n = supersets[0], max(n - 1, 2)
+            elif n < len(functions):
+                n = min(2 * n, len(functions))
+            else:
+                break
+        self.pool.close()
+        return functions
+
+    def cleanup(self):
+        shutil.rmtree(self.workdir, ignore_errors=True)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description='Finds a minimal set of functions of a verificarlo program responsible for the loss of '
+                    'significant digits of its outputs.',
+        epilog='The program must be compiled with verificarlo. Each configuration runs the same binary with '
+               'VERIFICARLO_SCOPE instrumenting a subset of the functions, the others are computed natively. '
+               'The significant digits of every number printed by the program are estimated over the samples.')
+    parser.add_argument('--functions', metavar='file',
+                        help='functions searched, one per line as for --functions-file '
+                             '(default: the functions of the program symbol table)')
+    parser.add_argument('--digits', metavar='digits', type=float, default=10,
+                        help='a configuration is unstable when a number has fewer significant digits (default 10)')
+    parser.add_argument('--samples', metavar='n', type=int, default=8,
+                        help='samples of each configuration (default 8)')
+    parser.add_argument('--mode', default='MCA', help='VERIFICARLO_MCAMODE of the runs (default MCA)')
+    parser.add_argument('--jobs', metavar='n', type=int, default=multiprocessing.cpu_count(),
+                        help='runs in parallel (default: the number of processors)')
+    parser.add_argument('--output', metavar='file',
+                        help='write the functions found, a --functions-file, to file instead of stdout')
+    parser.add_argument('--verbose', action='store_true', help='print the digits of each configuration')
+    parser.add_argument('command', nargs=argparse.REMAINDER, help='program and its arguments')
+    args = parser.parse_args()
+
+    if args.command and args.command[0] == '--':
+        args.command = args.command[1:]
+    if not args.command:
+        error('no program given')
+    if args.samples < 2:
+        error('--samples must be at least 2')
+    if args.jobs < 1:
+        error('--jobs must be positive')
+
+    localizer = Localizer(args)
+    try:
+        functions = localizer.search()
+    finally:
+        localizer.cleanup()
+
+    f = open(args.output, 'w') if args.output else sys.stdout
+    print('# {0:.2f} digits with {1} of {2} functions instrumented, {3} runs'.format(
+        localizer.digits[frozenset(functions)], len(functions), len(localizer.functions),
+        localizer.runs), file=f)
+    for name in functions:
+        print(name, file=f)
+    if args.output:
+        f.close()
@@ -0,0 +1,134 @@
+#!/usr/bin/env python
+#*******************************************************************************
+#                                                                              *
+#  This file is part of Verificarlo.                                           *
+#                                                                              *
+#  Copyright (c) 2015-2016                                                     *
+#     Universite de Versailles St-Quentin-en-Yvelines                          *
+#     CMLA, Ecole Normale Superieure de Cachan                                 *
+#                                                                              *
+#  Verificarlo is free software: you can redistribute it and/or modify         *
+#  it under the terms of the GNU General Public License as published by        *
+#  the Free Software Foundation, either version 3 of the License, or           *
+#  (at your option) any later version.                                         *
+#                                                                              *
+#  Verificarlo is distributed in the hope that it will be useful,              *
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+#  GNU General Public License for more details.                                *
+#                                                                              *
+#  You should have received a copy of the GNU General Public License           *
+#  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+#                                                                              *
+#*******************************************************************************
+
+from __future__ import print_function
+import argparse
+import math
+import struct
+import sys
+
+# Layout of the store written by vfc_probe, see vfcwrapper.c
+MAGIC = 0x45424f5250434656
+VERSION = 1
+HEADER = struct.Struct('=QIIII')
+NAME = struct.Struct('=I60s')
+STAT = struct.Struct('=Qdd')
+READY = 2
+
+def error(msg):
+    print(sys.argv[0] + ': ' + msg, file=sys.stderr)
+    sys.exit(1)
+
+def merge(a, b):
+    """ Merges two (count, mean, m2) accumulators (Chan et al.) """
+    na, ma, m2a = a
+    nb, mb, m2b = b
+    n = na + nb
+    if n == 0:
+        return a
+    delta = mb - ma
+    mean = ma + delta * nb / n
+    m2 = m2a + m2b + delta * delta * na * nb / n
+    return (n, mean, m2)
+
+def read_store(path):
+    """ Returns a dict mapping probe names to merged accumulators """
+    data = open(path, 'rb').read()
+    magic, version, max_probes, max_samples, samples = HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        error(path + ' is not a verificarlo probe store')
+
+    names = {}
+    offset = HEADER.size
+    for slot in range(max_probes):
+        state, name = NAME.unpack_from(data, offset + slot * NAME.size)
+        if state == READY:
+            names[slot] = name.split(b'\0', 1)[0].decode()
+
+    rows = offset + max_probes * NAME.size
+    probes = dict((name, (0, 0.0, 0.0)) for name in names.values())
+    for row in range(min(samples, max_samples)):
+        base = rows + row * max_probes * STAT.size
+        for slot, name in names.items():
+            stat = STAT.unpack_from(data, base + slot * STAT.size)
+            probes[name] = merge(probes[name], stat)
+    return min(samples, max_samples), probes
+
+def significant_digits(mean, std, base):
+    """ Significant digits s = -log_base(|std / mean|) """
+    if std == 0:
+        return float('inf')
+    if mean == 0:
+        return 0.0
+    return max(0.0, -math.log(abs(std / mean), base))
+
+def relative_error(value, reference):
+    """ Relative error |value - reference| / |reference| """
+    if value == reference:
+        return 0.0
+    if reference == 0:
+        return float('inf')
+    return abs((value - reference) / reference)
+
+def accurate_digits(error, base):
+    """ Digits s = -log_base(error) in agreement with the reference """
+    if error == 0:
+        return float('inf')
+    return max(0.0, -math.log(error, base))
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Reports the significant digits of the probes recorded with vfc_probe.')
+    parser.add_argument('store', help='probe store (VERIFICARLO_PROBE_FILE)')
+    parser.add_argument('--bits', action='store_true', help='report significant bits instead of decimal digits')
+    parser.add_argument('--reference', metavar='store', help='probe store of a REF mode run: report the relative error of each probe mean against it')
+    args = parser.parse_args()
+
+    samples, probes = read_store(args.store)
+    base = 2 if args.bits else 10
+    unit = 'bits' if args.bits else 'digits'
+
+    if args.reference:
+        _, references = read_store(args.reference)
+        print('# {0} samples'.format(samples))
+        print('# {0:<30} {1:>8} {2:>24} {3:>24} {4:>10} {5:>8}'.format(
+            'probe', 'count', 'mean', 'reference', 'error', unit))
+        for name in sorted(probes):
+            n, mean, m2 = probes[name]
+            if name not in references:
+                print('{0:<32} {1:>8} {2:>24.16e} {3:>24} {4:>10} {5:>8}'.format(
+                    name, n, mean, '-', '-', '-'))
+                continue
+            reference = references[name][1]
+            error = relative_error(mean, reference)
+            print('{0:<32} {1:>8} {2:>24.16e} {3:>24.16e} {4:>10.3e} {5:>8.2f}'.format(
+                name, n, mean, reference, error, accurate_digits(error, base)))
+        sys.exit(0)
+
+    print('# {0} samples'.format(samples))
+    print('# {0:<30} {1:>8} {2:>24} {3:>24} {4:>8}'.format('probe', 'count', 'mean', 'std', unit))
+    for name in sorted(probes):
+        n, mean, m2 = probes[name]
+        std = math.sqrt(m2 / (n - 1)) if n > 1 else 0.0
+        print('{0:<32} {1:>8} {2:>24.16e} {3:>24.16e} {4:>8.2f}'.format(
+            name, n, mean, std, significant_digits(mean, std, base)))
@@ -0,0 +1,123 @@
+#!/usr/bin/env python
+#*******************************************************************************
+#                                                                              *
+#  This file is part of Verificarlo.                                           *
+#                                                                              *
+#  Copyright (c) 2015-2016                                                     *
+#     Universite de Versailles St-Quentin-en-Yvelines                          *
+#     CMLA, Ecole Normale Superieure de Cachan                                 *
+#                                                                              *
+#  Verificarlo is free software: you can redistribute it and/or modify         *
+#  it under the terms of the GNU General Public License as published by        *
+#  the Free Software Foundation, either version 3 of the License, or           *
+#  (at your option) any later version.                                         *
+#                                                                              *
+#  Verificarlo is distributed in the hope that it will be useful,              *
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+#  GNU General Public License for more details.                                *
+#                                                                              *
+#  You should have received a copy of the GNU General Public License           *
+#  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+#                                                                              *
+#*******************************************************************************
+
+from __future__ import print_function
+import argparse
+import re
+import subprocess
+import sys
+
+# Converts the cancellation reports written by VERIFICARLO_CANCELLATION
+# into a site profile for verificarlo --site-profile. The call sites are
+# resolved with addr2line to the source line of the operation and to the
+# function containing it after inlining, the function instrumented by the
+# pass. The program must be compiled with -g.
+#
+# A profile line is: function file:line calls cancelled max_bits
+# Its first word is the function, so that a profile is also a functions
+# file for --functions-file.
+
+ADDRESS = re.compile(r'^0x[0-9a-fA-F]+$')
+DISCRIMINATOR = re.compile(r' \(discriminator \d+\)$')
+
+def error(msg):
+    print(sys.argv[0] + ': ' + msg, file=sys.stderr)
+    sys.exit(1)
+
+def read_report(path):
+    """ Returns the (cancelled, calls, max_bits, address, object) of each site """
+    sites = []
+    for line in open(path):
+        fields = line.split()
+        if not fields or fields[0].startswith('#'):
+            continue
+        if len(fields) < 5:
+            error(path + ' is not a cancellation report')
+        sites.append((int(fields[0]), int(fields[1]), int(fields[2]),
+                      int(fields[3], 16), fields[4]))
+    return sites
+
+def resolve(objectfile, addresses):
+    """ Returns a dict mapping each address to its (function, file:line),
+    None if it has no debug information """
+    output = subprocess.check_output(
+        ['addr2line', '-a', '-i', '-f', '-e', objectfile] + ['0x{0:x}'.format(a) for a in addresses])
+    frames = {}
+    function = None
+    for line in output.decode().splitlines():
+        if function is None and ADDRESS.match(line):
+            chain = frames.setdefault(int(line, 16), [])
+        elif function is None:
+            function = line
+        else:
+            chain.append((function, DISCRIMINATOR.sub('', line)))
+            function = None
+
+    locations = {}
+    for address, chain in frames.items():
+        # the first frame is the source line of the operation, the last
+        # one the function it was inlined in
+        if not chain or chain[-1][0] == '??' or chain[0][1].split(':')[-1] in ('?', '0'):
+            locations[address] = None
+        else:
+            locations[address] = (chain[-1][0], chain[0][1])
+    return locations
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='Converts cancellation reports (VERIFICARLO_CANCELLATION) into a site profile for verificarlo --site-profile.')
+    parser.add_argument('reports', nargs='+', help='cancellation reports, of one or several runs')
+    parser.add_argument('--output', metavar='file', help='write the profile to file instead of stdout')
+    args = parser.parse_args()
+
+    objects = {}
+    for report in args.reports:
+        for site in read_report(report):
+            objects.setdefault(site[4], []).append(site)
+
+    profile = {}
+    unresolved = 0
+    for objectfile, sites in objects.items():
+        if objectfile == '?':
+            unresolved += len(sites)
+            continue
+        locations = resolve(objectfile, sorted(set(s[3] for s in sites)))
+        for cancelled, calls, bits, address, _ in sites:
+            key = locations.get(address)
+            if key is None:
+                unresolved += 1
+                continue
+            c, n, b = profile.get(key, (0, 0, 0))
+            profile[key] = (c + cancelled, n + calls, max(b, bits))
+
+    f = open(args.output, 'w') if args.output else sys.stdout
+    if unresolved:
+        print('# {0} sites without debug information are not profiled'.format(unresolved), file=f)
+    print('# {0:<28} {1:<32} {2:>12} {3:>12} {4:>8}'.format(
+        'function', 'file:line', 'calls', 'cancelled', 'max_bits'), file=f)
+    for key in sorted(profile, key=lambda k: (-profile[k][2], -profile[k][0], -profile[k][1], k)):
+        cancelled, calls, bits = profile[key]
+        print('{0:<30} {1:<32} {2:>12} {3:>12} {4:>8}'.format(
+            key[0], key[1], calls, cancelled, bits), file=f)
+    if args.output:
+        f.close()
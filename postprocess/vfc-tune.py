@@ -0,0 +1,226 @@
+#!/usr/bin/env python
+#*******************************************************************************
+#                                                                              *
+#  This file is part of Verificarlo.                                           *
+#                                                                              *
+#  Copyright (c) 2015-2016                                                     *
+#     Universite de Versailles St-Quentin-en-Yvelines                          *
+#     CMLA, Ecole Normale Superieure de Cachan                                 *
+#                                                                              *
+#  Verificarlo is free software: you can redistribute it and/or modify         *
+#  it under the terms of the GNU General Public License as published by        *
+#  the Free Software Foundation, either version 3 of the License, or           *
+#  (at your option) any later version.                                         *
+#                                                                              *
+#  Verificarlo is distributed in the hope that it will be useful,              *
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+#  GNU General Public License for more details.                                *
+#                                                                              *
+#  You should have received a copy of the GNU General Public License           *
+#  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+#                                                                              *
+#*******************************************************************************
+
+from __future__ import print_function
+import argparse
+import math
+import multiprocessing
+import os
+import re
+import shlex
+import shutil
+import subprocess
+import sys
+import tempfile
+import threading
+from multiprocessing.pool import ThreadPool
+
+# Searches the functions of a program which can be computed at a lower
+# precision. A configuration lists the functions kept at full precision,
+# the other candidates are rounded to the lower precision with a
+# VERIFICARLO_SCOPE file: the program is built once and every
+# configuration is a run of the same binary.
+#
+# The search is the delta debugging algorithm ddmin (Zeller and Hildebrandt)
+# applied to the kept functions: it returns a set of kept functions from
+# which no function can be lowered alone, every other candidate is lowered.
+# The subsets and complements of each step are run concurrently.
+
+NUMBER = re.compile(r'[-+]?(?:(?:\d+\.?\d*|\.\d+)(?:[eE][-+]?\d+)?|\binf\b|\bnan\b)', re.IGNORECASE)
+
+def error(msg):
+    print(sys.argv[0] + ': ' + msg, file=sys.stderr)
+    sys.exit(1)
+
+def read_functions(path):
+    """ Returns the function names of a --functions-file, in order """
+    functions = []
+    for line in open(path):
+        name = line.strip()
+        if name and not name.startswith('#') and name not in functions:
+            functions.append(name)
+    return functions
+
+def write_scope(f, functions, precision, comments=()):
+    """ Writes a VERIFICARLO_SCOPE file rounding functions to precision bits """
+    for comment in comments:
+        print('# ' + comment, file=f)
+    for name in functions:
+        print('{0} {1}'.format(name, precision), file=f)
+
+def relative_error(value, reference):
+    """ Relative error |value - reference| / |reference| """
+    if value == reference or (math.isnan(value) and math.isnan(reference)):
+        return 0.0
+    if reference == 0 or math.isinf(reference) or math.isnan(value):
+        return float('inf')
+    return abs((value - reference) / reference)
+
+class Tuner(object):
+    def __init__(self, args):
+        self.args = args
+        self.candidates = read_functions(args.candidates)
+        self.workdir = tempfile.mkdtemp(prefix='vfc-tune.')
+        self.results = {}
+        self.lock = threading.Lock()
+        self.runs = 0
+
+    def run(self, name, scope):
+        """ Runs the program, returns the path of its output or None if it fails """
+        env = dict(os.environ)
+        env['VERIFICARLO_MCAMODE'] = self.args.mode
+        env.pop('VERIFICARLO_SCOPE', None)
+        if scope is not None:
+            env['VERIFICARLO_SCOPE'] = scope
+        output = os.path.join(self.workdir, name + '.out')
+        with open(output, 'w') as out:
+            status = subprocess.call(self.args.command, stdout=out, env=env)
+        with self.lock:
+            self.runs += 1
+        return output if status == 0 else None
+
+    def accurate(self, output):
+        """ Returns True if the output meets the accuracy criterion """
+        if self.args.check:
+            return subprocess.call(shlex.split(self.args.check) + [self.reference, output]) == 0
+
+        values = [float(x) for x in NUMBER.findall(open(output).read())]
+        if len(values) != len(self.references):
+            return False
+        tolerance = 10 ** -self.args.digits
+        return all(relative_error(v, r) <= tolerance for v, r in zip(values, self.references))
+
+    def test(self, kept):
+        """ Returns True if the program is accurate with the candidates out of
+        kept lowered, runs it once per configuration """
+        key = frozenset(kept)
+        with self.lock:
+            if key in self.results:
+                return self.results[key]
+            index = len(self.results)
+            self.results[key] = None
+
+        lowered = [f for f in self.candidates if f not in key]
+        scope = os.path.join(self.workdir, 'scope-{0}'.format(index))
+        with open(scope, 'w') as f:
+            write_scope(f, lowered, self.args.precision)
+        output = self.run('run-{0}'.format(index), scope)
+        passed = output is not None and self.accurate(output)
+        if self.args.verbose:
+            print('{0} lowered {1}: {2}'.format(
+                'pass' if passed else 'fail', len(lowered), ' '.join(lowered)), file=sys.stderr)
+
+        with self.lock:
+            self.results[key] = passed
+        return passed
+
+    def search(self):
+        """ Returns the 1-minimal list of candidates kept at full precision """
+        self.reference = self.run('reference', None)
+        if self.reference is None:
+            error('the program fails without lowering any function')
+        self.references = [float(x) for x in NUMBER.findall(open(self.reference).read())]
+
+        if not self.accurate(self.reference):
+            error('the full precision run does not meet the accuracy criterion')
+        if self.test([]):
+            return []
+
+        pool = ThreadPool(self.args.jobs)
+        kept = list(self.candidates)
+
+        n = 2
+        while len(kept) >= 2:
+            n = min(n, len(kept))
+            size = len(kept) / float(n)
+            chunks = [kept[int(i * size):int((i + 1) * size)] for i in range(n)]
+            complements = [[f for f in kept if f not in c] for c in chunks] if n > 2 else []
+            # the configurations of a step are independent runs
+            passed = pool.map(self.test, chunks + complements)
+
+            subsets = [c for c, p in zip(chunks, passed) if p]
+            supersets = [c for c, p in zip(complements, passed[len(chunks):]) if p]
+            if subsets:
+                kept, n = subsets[0], 2
+            elif supersets:
+                kept, n = supersets[0], max(n - 1, 2)
+            elif n < len(kept):
+                n = min(2 * n, len(kept))
+            else:
+                break
+        pool.close()
+        return kept
+
+    def cleanup(self):
+        shutil.rmtree(self.workdir, ignore_errors=True)
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description='Finds the functions of a verificarlo program which can be computed at a lower precision.',
+        epilog='The program must be compiled with verificarlo, at least with the candidate functions instrumented. '
+               'It is run with VERIFICARLO_SCOPE rounding the results of the lowered functions, '
+               'the functions out of the candidates are computed natively.')
+    parser.add_argument('--candidates', metavar='file', required=True,
+                        help='functions that may be lowered, one per line as for --functions-file')
+    parser.add_argument('--precision', metavar='bits', type=int, default=24,
+                        help='precision of the lowered functions (default 24, float)')
+    parser.add_argument('--digits', metavar='digits', type=float, default=6,
+                        help='decimal digits of each number printed by the program that must agree '
+                             'with the full precision run (default 6)')
+    parser.add_argument('--check', metavar='command',
+                        help='accuracy criterion replacing --digits: command called with the outputs of '
+                             'the full precision run and of the candidate, which passes if it exits with 0')
+    parser.add_argument('--mode', default='IEEE', help='VERIFICARLO_MCAMODE of the runs (default IEEE)')
+    parser.add_argument('--jobs', metavar='n', type=int, default=multiprocessing.cpu_count(),
+                        help='runs in parallel (default: the number of processors)')
+    parser.add_argument('--output', metavar='file',
+                        help='write the precision map, a VERIFICARLO_SCOPE file, to file instead of stdout')
+    parser.add_argument('--verbose', action='store_true', help='print each configuration tested')
+    parser.add_argument('command', nargs=argparse.REMAINDER, help='program and its arguments')
+    args = parser.parse_args()
+
+    if args.command and args.command[0] == '--':
+        args.command = args.command[1:]
+    if not args.command:
+        error('no program given')
+    if args.precision < 1:
+        error('--precision must be positive')
+    if args.jobs < 1:
+        error('--jobs must be positive')
+
+    tuner = Tuner(args)
+    try:
+        kept = tuner.search()
+    finally:
+        tuner.cleanup()
+
+    lowered = [f for f in tuner.candidates if f not in kept]
+    comments = ['{0} of {1} functions lowered to {2} bits, {3} runs'.format(
+                    len(lowered), len(tuner.candidates), args.precision, tuner.runs)]
+    comments += ['kept {0}'.format(f) for f in kept]
+    if args.output:
+        with open(args.output, 'w') as f:
+            write_scope(f, lowered, args.precision, comments)
+    else:
+        write_scope(sys.stdout, lowered, args.precision, comments)
@@ -63,6 +63,8 @@
 #define FLOAT_PMAN_SIZE    23
 //single precision mantissa size
 #define FLOAT_PREC         24
+//Single precision plus infinity encoding, also the exponent mask
+#define FLOAT_PLUS_INF     0x7F800000U
 
 //Sign encoding size
 #define SIGN_SIZE          1
@@ -0,0 +1,205 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+/**
+ * @file philox.h
+ *
+ * @brief Philox4x32-10 counter-based random number generator
+ *
+ * Philox is described in J. K. Salmon, M. A. Moraes, R. O. Dror and
+ * D. E. Shaw, "Parallel random numbers: as easy as 1, 2, 3", SC'11.
+ * Each output block is a bijection of a 128-bit counter under a 64-bit
+ * key: independent streams are obtained by giving them distinct keys or
+ * distinct counter ranges, without any shared state.
+ */
+
+#include <stdint.h>
+
+#define PHILOX_M4x32_0 UINT32_C(0xD2511F53)
+#define PHILOX_M4x32_1 UINT32_C(0xCD9E8D57)
+#define PHILOX_W32_0   UINT32_C(0x9E3779B9)
+#define PHILOX_W32_1   UINT32_C(0xBB67AE85)
+#define PHILOX_ROUNDS  10
+/* blocks computed together by philox4x32_generate_uint64_array */
+#define PHILOX_GROUP   8
+
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define PHILOX_TARGET_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef PHILOX_TARGET_CLONES
+#define PHILOX_TARGET_CLONES
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * philox4x32 stream: key, counter of the next block and the current
+ * output block
+ */
+struct PHILOX4X32_T {
+    uint32_t key[2];
+    uint32_t counter[4];
+    uint32_t block[4];
+    int index;
+};
+
+typedef struct PHILOX4X32_T philox4x32_t;
+
+/**
+ * This function computes the output block of a counter under a key.
+ * @param counter 128-bit counter
+ * @param key 64-bit key
+ * @param out output block
+ */
+inline static void philox4x32_10(const uint32_t counter[4],
+                                 const uint32_t key[2], uint32_t out[4]) {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    int i;
+
+    for (i = 0; i < PHILOX_ROUNDS; i++) {
+        uint64_t p0 = (uint64_t) PHILOX_M4x32_0 * c0;
+        uint64_t p1 = (uint64_t) PHILOX_M4x32_1 * c2;
+        uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t) p1;
+        c3 = (uint32_t) p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += PHILOX_W32_0;
+        k1 += PHILOX_W32_1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+/**
+ * This function initializes a stream.
+ * @param random philox stream
+ * @param key 64-bit key
+ * @param stream high 64 bits of the counter, the low 64 bits count blocks
+ */
+inline static void philox4x32_init(philox4x32_t * random, uint64_t key,
+                                   uint64_t stream) {
+    random->key[0] = (uint32_t) key;
+    random->key[1] = (uint32_t) (key >> 32);
+    random->counter[0] = 0;
+    random->counter[1] = 0;
+    random->counter[2] = (uint32_t) stream;
+    random->counter[3] = (uint32_t) (stream >> 32);
+    random->index = 4;
+}
+
+/**
+ * This function outputs 64-bit unsigned integer from the stream.
+ * @param random philox stream
+ * @return 64-bit unsigned integer r (0 <= r < 2^64)
+ */
+inline static uint64_t philox4x32_generate_uint64(philox4x32_t * random) {
+    if (random->index >= 4) {
+        philox4x32_10(random->counter, random->key, random->block);
+        if (++random->counter[0] == 0)
+            ++random->counter[1];
+        random->index = 0;
+    }
+    uint64_t x = ((uint64_t) random->block[random->index + 1] << 32)
+        | random->block[random->index];
+    random->index += 2;
+    return x;
+}
+
+/**
+ * This function fills an array with the next n 64-bit unsigned integers
+ * of the stream, as n calls to philox4x32_generate_uint64 would. Groups
+ * of PHILOX_GROUP independent blocks are computed lane by lane, a loop
+ * the compiler vectorizes; the function is cloned for AVX2 and AVX-512
+ * and the best clone is selected at load time from the CPU features.
+ * The stream must be at a block boundary and n must be even.
+ * @param random philox stream
+ * @param array output array
+ * @param n number of integers
+ */
+PHILOX_TARGET_CLONES
+static void philox4x32_generate_uint64_array(philox4x32_t * random,
+                                             uint64_t * array, int n) {
+    uint32_t c0 = random->counter[0];
+    int blocks = n / 2;
+    int groups = blocks - blocks % PHILOX_GROUP;
+    int i, j, r;
+
+    /* the low word of the counter wraps: let the scalar path carry it */
+    if ((uint64_t) c0 + blocks > UINT32_MAX) {
+        for (i = 0; i < n; i++)
+            array[i] = philox4x32_generate_uint64(random);
+        return;
+    }
+
+    for (i = 0; i < groups; i += PHILOX_GROUP) {
+        uint32_t x0[PHILOX_GROUP], x1[PHILOX_GROUP];
+        uint32_t x2[PHILOX_GROUP], x3[PHILOX_GROUP];
+        uint32_t k0 = random->key[0], k1 = random->key[1];
+
+        for (j = 0; j < PHILOX_GROUP; j++) {
+            x0[j] = c0 + i + j;
+            x1[j] = random->counter[1];
+            x2[j] = random->counter[2];
+            x3[j] = random->counter[3];
+        }
+        for (r = 0; r < PHILOX_ROUNDS; r++) {
+            for (j = 0; j < PHILOX_GROUP; j++) {
+                uint64_t p0 = (uint64_t) PHILOX_M4x32_0 * x0[j];
+                uint64_t p1 = (uint64_t) PHILOX_M4x32_1 * x2[j];
+                uint32_t n0 = (uint32_t) (p1 >> 32) ^ x1[j] ^ k0;
+                uint32_t n2 = (uint32_t) (p0 >> 32) ^ x3[j] ^ k1;
+                x1[j] = (uint32_t) p1;
+                x3[j] = (uint32_t) p0;
+                x0[j] = n0;
+                x2[j] = n2;
+            }
+            k0 += PHILOX_W32_0;
+            k1 += PHILOX_W32_1;
+        }
+        for (j = 0; j < PHILOX_GROUP; j++) {
+            array[2 * (i + j)] = ((uint64_t) x1[j] << 32) | x0[j];
+            array[2 * (i + j) + 1] = ((uint64_t) x3[j] << 32) | x2[j];
+        }
+    }
+
+    for (i = groups; i < blocks; i++) {
+        uint32_t counter[4] = { c0 + i, random->counter[1],
+                                random->counter[2], random->counter[3] };
+        uint32_t block[4];
+        philox4x32_10(counter, random->key, block);
+        array[2 * i] = ((uint64_t) block[1] << 32) | block[0];
+        array[2 * i + 1] = ((uint64_t) block[3] << 32) | block[2];
+    }
+    random->counter[0] = c0 + blocks;
+}
+
+/**
+ * This function outputs floating point number from the stream.
+ * This function is implemented using union trick.
+ * @param random philox stream
+ * @return floating point number r (0.0 < r < 1.0)
+ */
+inline static double philox4x32_generate_doubleOO(philox4x32_t * random) {
+    union {
+	uint64_t u;
+	double d;
+    } conv;
+    conv.u = (philox4x32_generate_uint64(random) >> 12)
+	| UINT64_C(0x3ff0000000000001);
+    return conv.d - 1.0;
+}
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
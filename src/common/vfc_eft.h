@@ -0,0 +1,185 @@
+/********************************************************************************
+ *                                                                              *
+ *  This file is part of Verificarlo.                                           *
+ *                                                                              *
+ *  Copyright (c) 2026                                                          *
+ *     Universite de Versailles St-Quentin-en-Yvelines                          *
+ *     CMLA, Ecole Normale Superieure de Cachan                                 *
+ *                                                                              *
+ *  Verificarlo is free software: you can redistribute it and/or modify         *
+ *  it under the terms of the GNU General Public License as published by        *
+ *  the Free Software Foundation, either version 3 of the License, or           *
+ *  (at your option) any later version.                                         *
+ *                                                                              *
+ *  Verificarlo is distributed in the hope that it will be useful,              *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ *  GNU General Public License for more details.                                *
+ *                                                                              *
+ *  You should have received a copy of the GNU General Public License           *
+ *  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+ *                                                                              *
+ ********************************************************************************/
+
+/* Error-free transformations and double-double arithmetic shared by the
+ * DD, RDROUND, CESTAC and SHADOW backends.
+ *
+ * The *_error functions return the exact rounding error of a native
+ * operation from its operands and its result rounded to nearest: float
+ * errors are computed in double, where the product of two floats and the
+ * remainder of their quotient are exact. Division errors are the exact
+ * remainder divided by the divisor. Product and division errors are not
+ * exact when they fall in the subnormal range.
+ *
+ * A double-double is the unevaluated sum hi + lo of two doubles with
+ * |lo| <= ulp(hi)/2. Its operations are the classic Dekker / QD ones,
+ * accurate to about 2^-104. */
+
+#ifndef VFC_EFT_H
+#define VFC_EFT_H
+
+#include <math.h>
+#include <stdint.h>
+
+/* Clones the kernels calling fma() for FMA capable x86 processors. Other
+ * targets call fma() from the libm, which is exact but slower. */
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define VFC_FMA_TARGET_CLONES __attribute__((target_clones("fma", "default")))
+#endif
+#endif
+#ifndef VFC_FMA_TARGET_CLONES
+#define VFC_FMA_TARGET_CLONES
+#endif
+
+/* Exact error of s = a + b (TwoSum) */
+static inline double dadd_error(double a, double b, double s) {
+    double bb = s - a;
+    return (a - (s - bb)) + (b - bb);
+}
+
+static inline double fadd_error(float a, float b, float s) {
+    float bb = s - a;
+    return (a - (s - bb)) + (b - bb);
+}
+
+/* Exact error of p = a * b (TwoProd) */
+static inline double dmul_error(double a, double b, double p) {
+    return fma(a, b, -p);
+}
+
+static inline double fmul_error(float a, float b, float p) {
+    return (double) a * b - p;
+}
+
+/* Error of q = a / b, 0 when an operand is not finite */
+static inline double ddiv_error(double a, double b, double q) {
+    if (!isfinite(a) || !isfinite(b))
+        return 0;
+    return fma(-q, b, a) / b;
+}
+
+static inline double fdiv_error(float a, float b, float q) {
+    if (!isfinite(a) || !isfinite(b))
+        return 0;
+    return (a - (double) q * b) / b;
+}
+
+/* Returns the neighbour of the finite x in the direction of err */
+static inline double dnext(double x, double err) {
+    union {
+        uint64_t u;
+        double d;
+    } hex = { .d = x };
+
+    if (x == 0) {
+        hex.u = 1;
+        return err > 0 ? hex.d : -hex.d;
+    }
+    /* the magnitude grows when x and err have the same sign */
+    if ((x > 0) == (err > 0))
+        hex.u++;
+    else
+        hex.u--;
+    return hex.d;
+}
+
+static inline float fnext(float x, double err) {
+    union {
+        uint32_t u;
+        float f;
+    } hex = { .f = x };
+
+    if (x == 0) {
+        hex.u = 1;
+        return err > 0 ? hex.f : -hex.f;
+    }
+    if ((x > 0) == (err > 0))
+        hex.u++;
+    else
+        hex.u--;
+    return hex.f;
+}
+
+typedef struct {
+    double hi;
+    double lo;
+} dd_t;
+
+/* Exact a + b, requires |a| >= |b| or a == 0 */
+static inline dd_t fast_two_sum(double a, double b) {
+    dd_t r;
+    r.hi = a + b;
+    r.lo = b - (r.hi - a);
+    return r;
+}
+
+/* Exact a + b */
+static inline dd_t two_sum(double a, double b) {
+    dd_t r;
+    r.hi = a + b;
+    r.lo = dadd_error(a, b, r.hi);
+    return r;
+}
+
+/* Exact a * b */
+static inline dd_t two_prod(double a, double b) {
+    dd_t r;
+    r.hi = a * b;
+    r.lo = dmul_error(a, b, r.hi);
+    return r;
+}
+
+static inline dd_t dd_add(dd_t a, dd_t b) {
+    dd_t s = two_sum(a.hi, b.hi);
+    dd_t t = two_sum(a.lo, b.lo);
+    s.lo += t.hi;
+    s = fast_two_sum(s.hi, s.lo);
+    s.lo += t.lo;
+    return fast_two_sum(s.hi, s.lo);
+}
+
+static inline dd_t dd_neg(dd_t a) {
+    a.hi = -a.hi;
+    a.lo = -a.lo;
+    return a;
+}
+
+static inline dd_t dd_mul(dd_t a, dd_t b) {
+    dd_t p = two_prod(a.hi, b.hi);
+    p.lo += a.hi * b.lo + a.lo * b.hi;
+    return fast_two_sum(p.hi, p.lo);
+}
+
+static inline dd_t dd_div(dd_t a, dd_t b) {
+    double q1 = a.hi / b.hi;
+    /* remainder a - q1 * b */
+    dd_t p = two_prod(q1, b.hi);
+    p.lo += q1 * b.lo;
+    dd_t r = two_sum(a.hi, -p.hi);
+    r.lo += a.lo - p.lo;
+    double q2 = (r.hi + r.lo) / b.hi;
+    return fast_two_sum(q1, q2);
+}
+
+#endif
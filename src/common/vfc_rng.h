@@ -0,0 +1,269 @@
+/********************************************************************************
+ *                                                                              *
+ *  This file is part of Verificarlo.                                           *
+ *                                                                              *
+ *  Copyright (c) 2015                                                          *
+ *     Universite de Versailles St-Quentin-en-Yvelines                          *
+ *     CMLA, Ecole Normale Superieure de Cachan                                 *
+ *                                                                              *
+ *  Verificarlo is free software: you can redistribute it and/or modify         *
+ *  it under the terms of the GNU General Public License as published by        *
+ *  the Free Software Foundation, either version 3 of the License, or           *
+ *  (at your option) any later version.                                         *
+ *                                                                              *
+ *  Verificarlo is distributed in the hope that it will be useful,              *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ *  GNU General Public License for more details.                                *
+ *                                                                              *
+ *  You should have received a copy of the GNU General Public License           *
+ *  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+ *                                                                              *
+ ********************************************************************************/
+
+/* Per-thread random streams shared by the MCA backends.
+ *
+ * Each thread draws from its own stream, derived without any shared state
+ * from the (seed, sample, backend, thread, rank) tuple configured by
+ * vfcwrapper: a sample is replayed exactly by running it again with the
+ * same VERIFICARLO_SEED and VERIFICARLO_SAMPLE.
+ *
+ * The thread is the id assigned with vfc_rng_set_thread, so that each
+ * thread of a multithreaded sample replays its stream. Threads without
+ * an id are numbered in the order of their first random draw after
+ * seeding, which depends on the scheduling. A forked child derives a
+ * new key from the parent key and the fork number so that its streams
+ * never overlap the parent ones.
+ *
+ * Random values are not generated one at a time on the critical path of
+ * the arithmetic: each thread refills a buffer of VERIFICARLO_RNG_BUFFER
+ * values at once and the noise functions load from it. The buffer holds
+ * the raw 64-bit outputs in stream order, so the values drawn are the
+ * same whatever the buffer size. The Philox and xoshiro256 refills are
+ * vectorized and dispatched to the AVX2 or AVX-512 code at load time.
+ *
+ * The stream of a thread is allocated on its first draw and only its
+ * address is thread local. With the initial-exec model reading it is a
+ * single load, where the default model of shared libraries calls
+ * __tls_get_addr; one pointer easily fits in the static TLS that the
+ * dynamic loader reserves for the backends opened with dlopen.
+ *
+ * This header defines static state and must be included by a single
+ * translation unit of each backend. */
+
+#ifndef VFC_RNG_H
+#define VFC_RNG_H
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "philox.h"
+#include "tinymt64.h"
+#include "xoshiro256.h"
+#include "../vfcwrapper/vfcwrapper.h"
+
+/* per-thread random stream */
+struct vfc_rng_t {
+    uint64_t generation; /* vfc_rng_generation when the stream was derived */
+    int generator;
+    tinymt64_t tinymt;
+    philox4x32_t philox;
+    xoshiro256_t xoshiro;
+    uint32_t next;       /* next value to draw from buffer */
+    uint32_t size;       /* values generated per refill */
+    uint64_t buffer[VFC_RNG_BUFFER_MAX];
+};
+
+static struct vfc_rng_config_t vfc_rng_config;
+static uint64_t vfc_rng_key;
+static uint64_t vfc_rng_generation = 0;
+static uint32_t vfc_rng_threads = 0;
+static uint32_t vfc_rng_fork_id;
+static pthread_key_t vfc_rng_free_key;
+static __thread struct vfc_rng_t * vfc_rng_local
+    __attribute__((tls_model("initial-exec")));
+
+/* splitmix64 finalizer, used to derive keys */
+static inline uint64_t vfc_rng_mix(uint64_t x) {
+    x += UINT64_C(0x9e3779b97f4a7c15);
+    x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+    x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+    return x ^ (x >> 31);
+}
+
+/* derives the stream of the calling thread */
+static void vfc_rng_derive(struct vfc_rng_t * rng) {
+    int id = vfc_rng_config.thread != NULL ? vfc_rng_config.thread() : -1;
+    uint64_t thread;
+
+    /* the high bit keeps the assigned ids apart from the numbered threads */
+    if (id >= 0)
+        thread = (uint32_t) id | UINT32_C(0x80000000);
+    else
+        thread = __atomic_fetch_add(&vfc_rng_threads, 1, __ATOMIC_RELAXED) & UINT32_C(0x7fffffff);
+
+    rng->generator = vfc_rng_config.generator;
+    if (rng->generator == VFC_RNG_PHILOX) {
+        /* the key identifies the sample, the counter high words the
+         * thread and rank, the counter low words the block index */
+        philox4x32_init(&rng->philox, vfc_rng_key,
+                        thread | ((uint64_t) vfc_rng_config.rank << 32));
+    } else if (rng->generator == VFC_RNG_XOSHIRO) {
+        /* the first lane is seeded from the key, thread and rank; the
+         * other lanes are jumped from it */
+        uint64_t x = vfc_rng_key ^ vfc_rng_mix(thread ^ vfc_rng_mix(vfc_rng_config.rank));
+        uint64_t seed[4];
+        int k;
+        for (k = 0; k < 4; k++) {
+            x += UINT64_C(0x9e3779b97f4a7c15);
+            seed[k] = vfc_rng_mix(x);
+        }
+        if ((seed[0] | seed[1] | seed[2] | seed[3]) == 0)
+            seed[0] = 1;
+        xoshiro256_init(&rng->xoshiro, seed);
+    } else {
+        uint64_t init_key[3] = { vfc_rng_key, thread, vfc_rng_config.rank };
+        /* the stream is allocated with malloc: clear the parameters that
+         * tinymt64_init_by_array reads, as for a static state */
+        rng->tinymt.mat1 = 0;
+        rng->tinymt.mat2 = 0;
+        rng->tinymt.tmat = 0;
+        tinymt64_init_by_array(&rng->tinymt, init_key, 3);
+    }
+    /* philox generates two values per block, xoshiro one per lane */
+    rng->size = vfc_rng_config.buffer;
+    if (rng->size == 0 || rng->size > VFC_RNG_BUFFER_MAX)
+        rng->size = VFC_RNG_BUFFER_MAX;
+    if (rng->generator == VFC_RNG_PHILOX && (rng->size & 1))
+        rng->size++;
+    if (rng->generator == VFC_RNG_XOSHIRO)
+        rng->size = (rng->size + XOSHIRO256_LANES - 1) / XOSHIRO256_LANES * XOSHIRO256_LANES;
+    rng->next = rng->size;
+    rng->generation = __atomic_load_n(&vfc_rng_generation, __ATOMIC_ACQUIRE);
+}
+
+static void vfc_rng_atfork_prepare(void) {
+    vfc_rng_fork_id = __atomic_fetch_add(&vfc_rng_threads, 1, __ATOMIC_RELAXED);
+}
+
+static void vfc_rng_atfork_child(void) {
+    vfc_rng_key = vfc_rng_mix(vfc_rng_key ^ vfc_rng_mix(vfc_rng_fork_id));
+    vfc_rng_threads = 0;
+    vfc_rng_generation++;
+}
+
+/* releases the stream of an exiting thread */
+static void vfc_rng_free(void * rng) {
+    vfc_rng_local = NULL;
+    free(rng);
+}
+
+static pthread_once_t vfc_rng_once = PTHREAD_ONCE_INIT;
+
+static void vfc_rng_init_once(void) {
+    pthread_key_create(&vfc_rng_free_key, vfc_rng_free);
+    pthread_atfork(vfc_rng_atfork_prepare, NULL, vfc_rng_atfork_child);
+}
+
+/* (re)seeds the streams of all threads. Each backend library has its own
+ * copy of this state: the backend id (MCABACKEND_*) is mixed into the key
+ * so that the backends combined by AUTO draw from independent streams. */
+static void vfc_rng_seed(const struct vfc_rng_config_t * config, int backend) {
+    vfc_rng_config = *config;
+    vfc_rng_key = vfc_rng_mix(config->seed ^ vfc_rng_mix(config->sample
+                                                        ^ vfc_rng_mix(backend)));
+    vfc_rng_threads = 0;
+    __atomic_add_fetch(&vfc_rng_generation, 1, __ATOMIC_RELEASE);
+
+    pthread_once(&vfc_rng_once, vfc_rng_init_once);
+}
+
+/* generates the next block of values of the calling thread stream and
+ * returns the first one */
+static uint64_t __attribute__((noinline)) vfc_rng_refill(struct vfc_rng_t * rng) {
+    if (rng == NULL) {
+        rng = malloc(sizeof(struct vfc_rng_t));
+        if (rng == NULL) {
+            perror("vfc_rng: cannot allocate the thread random stream");
+            abort();
+        }
+        pthread_once(&vfc_rng_once, vfc_rng_init_once);
+        pthread_setspecific(vfc_rng_free_key, rng);
+        vfc_rng_local = rng;
+        vfc_rng_derive(rng);
+    } else if (rng->generation != __atomic_load_n(&vfc_rng_generation, __ATOMIC_RELAXED)) {
+        vfc_rng_derive(rng);
+    }
+
+    uint64_t * buffer = rng->buffer;
+    uint32_t i;
+    if (rng->generator == VFC_RNG_PHILOX) {
+        philox4x32_generate_uint64_array(&rng->philox, buffer, rng->size);
+    } else if (rng->generator == VFC_RNG_XOSHIRO) {
+        xoshiro256_generate_uint64_array(&rng->xoshiro, buffer, rng->size);
+    } else {
+        for (i = 0; i < rng->size; i++)
+            buffer[i] = tinymt64_generate_uint64(&rng->tinymt);
+    }
+    rng->next = 1;
+    return buffer[0];
+}
+
+/* Returns a random 64-bit unsigned integer */
+static inline uint64_t vfc_rng_uint64(void) {
+    struct vfc_rng_t * rng = vfc_rng_local;
+    if (__builtin_expect(rng != NULL, 1)) {
+        uint32_t next = rng->next;
+        if (__builtin_expect(next < rng->size, 1)
+            && rng->generation == __atomic_load_n(&vfc_rng_generation, __ATOMIC_RELAXED)) {
+            rng->next = next + 1;
+            return rng->buffer[next];
+        }
+    }
+    return vfc_rng_refill(rng);
+}
+
+/* Converts a random 64-bit integer to a double in the (0,1) open
+ * interval as tinymt64_generate_doubleOO and philox4x32_generate_doubleOO do */
+static inline double vfc_rng_doubleOO_from(uint64_t u) {
+    union {
+        uint64_t u;
+        double d;
+    } conv;
+    conv.u = (u >> 12) | UINT64_C(0x3ff0000000000001);
+    return conv.d - 1.0;
+}
+
+/* Returns a random double in the (0,1) open interval */
+static inline double vfc_rng_doubleOO(void) {
+    return vfc_rng_doubleOO_from(vfc_rng_uint64());
+}
+
+/* Fills array with n random doubles in the (0,1) open interval, the
+ * values that n calls to vfc_rng_doubleOO would return. The values are
+ * converted in place from the thread buffer, in a loop that vectorizes */
+static inline void vfc_rng_doubleOO_array(double * array, int n) {
+    while (n > 0) {
+        struct vfc_rng_t * rng = vfc_rng_local;
+        if (rng == NULL || rng->next >= rng->size
+            || rng->generation != __atomic_load_n(&vfc_rng_generation, __ATOMIC_RELAXED)) {
+            *array++ = vfc_rng_doubleOO_from(vfc_rng_refill(rng));
+            n--;
+            continue;
+        }
+
+        uint32_t next = rng->next;
+        int k = rng->size - next, i;
+        if (k > n)
+            k = n;
+        for (i = 0; i < k; i++)
+            array[i] = vfc_rng_doubleOO_from(rng->buffer[next + i]);
+        rng->next = next + k;
+        array += k;
+        n -= k;
+    }
+}
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef XOSHIRO256_H
+#define XOSHIRO256_H
+/**
+ * @file xoshiro256.h
+ *
+ * @brief xoshiro256++ with several independent lanes stepped together
+ *
+ * xoshiro256++ is described in D. Blackman and S. Vigna, "Scrambled
+ * linear pseudorandom number generators", ACM TOMS 47(4), 2021. Each
+ * lane is a full xoshiro256++ generator; lane i+1 starts 2^128 steps
+ * after lane i (jump function), so the lanes never overlap.
+ *
+ * The lane states are stored as structure of arrays: stepping all the
+ * lanes is a loop of 64-bit shifts, xors and adds that the compiler
+ * turns into SSE2, AVX2 or AVX-512 instructions. The bulk generation
+ * function is cloned for these instruction sets and the best clone is
+ * selected at load time from the CPU features.
+ */
+
+#include <stdint.h>
+
+#define XOSHIRO256_LANES 8
+
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define XOSHIRO256_TARGET_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef XOSHIRO256_TARGET_CLONES
+#define XOSHIRO256_TARGET_CLONES
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * xoshiro256 lanes: s[k][lane] is the word k of the state of a lane
+ */
+struct XOSHIRO256_T {
+    uint64_t s[4][XOSHIRO256_LANES];
+};
+
+typedef struct XOSHIRO256_T xoshiro256_t;
+
+inline static uint64_t xoshiro256_rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * This function advances a single lane state by 2^128 steps.
+ * @param s state of the lane
+ */
+inline static void xoshiro256_jump(uint64_t s[4]) {
+    static const uint64_t jump[4] = {
+        UINT64_C(0x180ec6d33cfd0aba), UINT64_C(0xd5a61266f0c9392c),
+        UINT64_C(0xa9582618e03fc9aa), UINT64_C(0x39abdc4529b1661c)
+    };
+    uint64_t t[4] = { 0, 0, 0, 0 };
+    int i, b, k;
+
+    for (i = 0; i < 4; i++) {
+        for (b = 0; b < 64; b++) {
+            if (jump[i] & (UINT64_C(1) << b)) {
+                for (k = 0; k < 4; k++)
+                    t[k] ^= s[k];
+            }
+            uint64_t r = s[1] << 17;
+            s[2] ^= s[0];
+            s[3] ^= s[1];
+            s[1] ^= s[2];
+            s[0] ^= s[3];
+            s[2] ^= r;
+            s[3] = xoshiro256_rotl(s[3], 45);
+        }
+    }
+    for (k = 0; k < 4; k++)
+        s[k] = t[k];
+}
+
+/**
+ * This function initializes the lanes from a 256-bit seed.
+ * @param random xoshiro256 lanes
+ * @param seed state of the first lane, must not be all zero
+ */
+inline static void xoshiro256_init(xoshiro256_t * random,
+                                   const uint64_t seed[4]) {
+    uint64_t s[4] = { seed[0], seed[1], seed[2], seed[3] };
+    int lane, k;
+
+    for (lane = 0; lane < XOSHIRO256_LANES; lane++) {
+        for (k = 0; k < 4; k++)
+            random->s[k][lane] = s[k];
+        xoshiro256_jump(s);
+    }
+}
+
+/**
+ * This function fills an array with 64-bit unsigned integers, one from
+ * each lane in turn.
+ * @param random xoshiro256 lanes
+ * @param array output array
+ * @param n number of integers, a multiple of XOSHIRO256_LANES
+ */
+XOSHIRO256_TARGET_CLONES
+static void xoshiro256_generate_uint64_array(xoshiro256_t * random,
+                                             uint64_t * array, int n) {
+    uint64_t s0[XOSHIRO256_LANES], s1[XOSHIRO256_LANES];
+    uint64_t s2[XOSHIRO256_LANES], s3[XOSHIRO256_LANES];
+    int i, lane;
+
+    for (lane = 0; lane < XOSHIRO256_LANES; lane++) {
+        s0[lane] = random->s[0][lane];
+        s1[lane] = random->s[1][lane];
+        s2[lane] = random->s[2][lane];
+        s3[lane] = random->s[3][lane];
+    }
+
+    for (i = 0; i < n; i += XOSHIRO256_LANES) {
+        for (lane = 0; lane < XOSHIRO256_LANES; lane++) {
+            uint64_t t = s1[lane] << 17;
+            array[i + lane] = xoshiro256_rotl(s0[lane] + s3[lane], 23) + s0[lane];
+            s2[lane] ^= s0[lane];
+            s3[lane] ^= s1[lane];
+            s1[lane] ^= s2[lane];
+            s0[lane] ^= s3[lane];
+            s2[lane] ^= t;
+            s3[lane] = xoshiro256_rotl(s3[lane], 45);
+        }
+    }
+
+    for (lane = 0; lane < XOSHIRO256_LANES; lane++) {
+        random->s[0][lane] = s0[lane];
+        random->s[1][lane] = s1[lane];
+        random->s[2][lane] = s2[lane];
+        random->s[3][lane] = s3[lane];
+    }
+}
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -0,0 +1,512 @@
+/********************************************************************************
+ *                                                                              *
+ *  This file is part of Verificarlo.                                           *
+ *                                                                              *
+ *  Copyright (c) 2026                                                          *
+ *     Universite de Versailles St-Quentin-en-Yvelines                          *
+ *     CMLA, Ecole Normale Superieure de Cachan                                 *
+ *                                                                              *
+ *  Verificarlo is free software: you can redistribute it and/or modify         *
+ *  it under the terms of the GNU General Public License as published by        *
+ *  the Free Software Foundation, either version 3 of the License, or           *
+ *  (at your option) any later version.                                         *
+ *                                                                              *
+ *  Verificarlo is distributed in the hope that it will be useful,              *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ *  GNU General Public License for more details.                                *
+ *                                                                              *
+ *  You should have received a copy of the GNU General Public License           *
+ *  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+ *                                                                              *
+ ********************************************************************************/
+
+
+// Changelog:
+//
+// 2026-10-19 Synchronous three samples backend
+//
+// After the CESTAC method (J. Vignes, "A stochastic arithmetic for
+// reliable scientific computation", Math. Comput. Simul. 35, 1993). Each
+// operation is computed three times, each inexact result being rounded up
+// or down with probability 1/2, and the number of significant digits of
+// any value is estimated from its three samples with a Student test: one
+// run gives the estimate that MCA needs a campaign of runs for. The
+// rounding errors are exact, see vfc_eft.h.
+//
+// The instrumented code only carries the first sample. The three samples
+// of each result are kept in a per-thread shadow cache indexed by the
+// bits of the first sample, where the operands of the next operations
+// find them. A value absent from the cache (a constant, a value computed
+// by code that is not instrumented, or an entry evicted by a collision)
+// is taken as exact: its three samples are equal. Two results with the
+// same bits share one entry, the last computed.
+//
+// Samples are computed in MCA and RR modes, IEEE and PB modes compute
+// the native operations and all values are then exact. The virtual
+// precision is ignored.
+//
+
+#include <float.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "libmca-cestac.h"
+#include "../vfcwrapper/vfcwrapper.h"
+#include "../common/vfc_eft.h"
+#include "../common/vfc_rng.h"
+
+//possible op values
+#define MCA_ADD 1
+#define MCA_SUB 2
+#define MCA_MUL 3
+#define MCA_DIV 4
+
+// number of synchronous samples
+#define CESTAC_SAMPLES 3
+
+// Student t for 2 degrees of freedom at the 95% confidence level
+#define CESTAC_STUDENT 4.302652729911275
+
+// each thread caches the samples of the last 2^CESTAC_CACHE_BITS
+// results of each type
+#define CESTAC_CACHE_BITS 16
+#define CESTAC_CACHE_SIZE (1 << CESTAC_CACHE_BITS)
+
+static void _mca_select_kernels(int mode);
+
+/******************** MCA CONTROL FUNCTIONS *******************
+* The following functions are used to set virtual precision and
+* MCA mode of operation.
+***************************************************************/
+
+/* incremented when the mode or the seed change, to drop the cached
+ * samples of the previous configuration */
+static uint64_t _cestac_generation = 0;
+
+static int _set_mca_mode(int mode){
+	if (mode < 0 || mode > 3)
+		return -1;
+
+	__atomic_add_fetch(&_cestac_generation, 1, __ATOMIC_RELEASE);
+	_mca_select_kernels(mode);
+	return 0;
+}
+
+static int _set_mca_precision(int precision){
+	/* ignored, results are rounded at their native precision */
+	(void)precision;
+	return 0;
+}
+
+/******************** MCA RANDOM FUNCTIONS ********************
+* The following functions are used to calculate the random
+* roundings
+***************************************************************/
+
+static uint64_t _mca_rand_bits(void) {
+	/* Returns 64 random bits, one per sample rounding */
+	return vfc_rng_uint64();
+}
+
+static void _mca_seed(const struct vfc_rng_config_t *config) {
+	/* Each thread derives its own stream from the configuration */
+	vfc_rng_seed(config, MCABACKEND_CESTAC);
+	__atomic_add_fetch(&_cestac_generation, 1, __ATOMIC_RELEASE);
+}
+
+/* Rounds the exact result x + err, where x is the nearest double, up or
+ * down as the CESTAC method does: to the neighbour of x in the direction
+ * of err when the random bit is set, and to x otherwise */
+static inline double dround(double x, double err, uint64_t bit) {
+	if (err == 0 || !isfinite(x) || !bit)
+		return x;
+	return dnext(x, err);
+}
+
+static inline float fround(float x, double err, uint64_t bit) {
+	if (err == 0 || !isfinite(x) || !bit)
+		return x;
+	return fnext(x, err);
+}
+
+/******************** SHADOW CACHE ****************************
+* The samples of the results computed by a thread, in two direct
+* mapped tables indexed by a hash of the first sample bits. The
+* cache of a thread is allocated on its first operation and only
+* its address is thread local, as the random streams of vfc_rng.h.
+***************************************************************/
+
+struct cestac_dentry {
+	uint64_t key;                   /* bits of x[0] */
+	double x[CESTAC_SAMPLES];
+};
+
+struct cestac_fentry {
+	uint32_t key;                   /* bits of x[0] */
+	float x[CESTAC_SAMPLES];
+};
+
+struct cestac_cache_t {
+	uint64_t generation;            /* _cestac_generation when allocated */
+	struct cestac_dentry d[CESTAC_CACHE_SIZE];
+	struct cestac_fentry f[CESTAC_CACHE_SIZE];
+};
+
+static pthread_key_t _cestac_free_key;
+static pthread_once_t _cestac_once = PTHREAD_ONCE_INIT;
+static __thread struct cestac_cache_t * _cestac_local
+	__attribute__((tls_model("initial-exec")));
+
+/* releases the cache of an exiting thread */
+static void _cestac_free(void * cache) {
+	_cestac_local = NULL;
+	free(cache);
+}
+
+static void _cestac_init_once(void) {
+	pthread_key_create(&_cestac_free_key, _cestac_free);
+}
+
+/* Allocates a cache where every entry holds the exact value zero. calloc
+ * maps large blocks lazily, so only the entries used are touched. */
+static struct cestac_cache_t * __attribute__((noinline)) _cestac_cache_new(void) {
+	free(_cestac_local);
+	struct cestac_cache_t * cache = calloc(1, sizeof(struct cestac_cache_t));
+	if (cache == NULL) {
+		perror("mcacestac: cannot allocate the thread shadow cache");
+		abort();
+	}
+	cache->generation = __atomic_load_n(&_cestac_generation, __ATOMIC_ACQUIRE);
+	pthread_once(&_cestac_once, _cestac_init_once);
+	pthread_setspecific(_cestac_free_key, cache);
+	_cestac_local = cache;
+	return cache;
+}
+
+/* Returns the cache of the calling thread */
+static inline struct cestac_cache_t * _cestac_cache(void) {
+	struct cestac_cache_t * cache = _cestac_local;
+	if (__builtin_expect(cache != NULL, 1)
+	    && cache->generation == __atomic_load_n(&_cestac_generation, __ATOMIC_RELAXED))
+		return cache;
+	return _cestac_cache_new();
+}
+
+static inline uint32_t _cestac_hash(uint64_t key) {
+	return (uint32_t) ((key * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - CESTAC_CACHE_BITS));
+}
+
+/* Loads the samples of a. The samples of -a are those of a negated:
+ * negations are not instrumented. */
+static inline void _cestac_dload(const struct cestac_cache_t * cache,
+                                 double a, double x[CESTAC_SAMPLES]) {
+	union {
+		uint64_t u;
+		double d;
+	} hex = { .d = a };
+	int i;
+
+	const struct cestac_dentry * e = &cache->d[_cestac_hash(hex.u)];
+	if (__builtin_expect(e->key == hex.u, 1)) {
+		for (i = 0; i < CESTAC_SAMPLES; i++)
+			x[i] = e->x[i];
+		return;
+	}
+	hex.u ^= UINT64_C(1) << 63;
+	e = &cache->d[_cestac_hash(hex.u)];
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		x[i] = e->key == hex.u ? -e->x[i] : a;
+	x[0] = a;
+}
+
+static inline void _cestac_fload(const struct cestac_cache_t * cache,
+                                 float a, float x[CESTAC_SAMPLES]) {
+	union {
+		uint32_t u;
+		float f;
+	} hex = { .f = a };
+	int i;
+
+	const struct cestac_fentry * e = &cache->f[_cestac_hash(hex.u)];
+	if (__builtin_expect(e->key == hex.u, 1)) {
+		for (i = 0; i < CESTAC_SAMPLES; i++)
+			x[i] = e->x[i];
+		return;
+	}
+	hex.u ^= UINT32_C(1) << 31;
+	e = &cache->f[_cestac_hash(hex.u)];
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		x[i] = e->key == hex.u ? -e->x[i] : a;
+	x[0] = a;
+}
+
+static inline void _cestac_dstore(struct cestac_cache_t * cache,
+                                  const double x[CESTAC_SAMPLES]) {
+	union {
+		uint64_t u;
+		double d;
+	} hex = { .d = x[0] };
+	int i;
+
+	struct cestac_dentry * e = &cache->d[_cestac_hash(hex.u)];
+	e->key = hex.u;
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		e->x[i] = x[i];
+}
+
+static inline void _cestac_fstore(struct cestac_cache_t * cache,
+                                  const float x[CESTAC_SAMPLES]) {
+	union {
+		uint32_t u;
+		float f;
+	} hex = { .f = x[0] };
+	int i;
+
+	struct cestac_fentry * e = &cache->f[_cestac_hash(hex.u)];
+	e->key = hex.u;
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		e->x[i] = x[i];
+}
+
+/******************** SIGNIFICANT DIGITS **********************
+* The number of decimal significant digits common to the samples
+* is estimated as log10(sqrt(N) |mean| / (t sigma)), clamped
+* between 0 and the digits of the type.
+***************************************************************/
+
+static double _cestac_digits(const double x[CESTAC_SAMPLES], double max) {
+	double mean = 0, var = 0;
+	int i;
+
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		mean += x[i];
+	mean /= CESTAC_SAMPLES;
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		var += (x[i] - mean) * (x[i] - mean);
+	var /= CESTAC_SAMPLES - 1;
+
+	if (var == 0)
+		return max;
+	if (!isfinite(mean) || !isfinite(var))
+		return 0;
+
+	double digits = log10(sqrt(CESTAC_SAMPLES) * fabs(mean)
+	                      / (CESTAC_STUDENT * sqrt(var)));
+	if (!(digits > 0))
+		return 0;
+	return digits < max ? digits : max;
+}
+
+static double _doubledigits(double a) {
+	double x[CESTAC_SAMPLES];
+	_cestac_dload(_cestac_cache(), a, x);
+	return _cestac_digits(x, DBL_MANT_DIG * log10(2));
+}
+
+static double _floatdigits(float a) {
+	float x[CESTAC_SAMPLES];
+	double y[CESTAC_SAMPLES];
+	int i;
+
+	_cestac_fload(_cestac_cache(), a, x);
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		y[i] = x[i];
+	return _cestac_digits(y, FLT_MANT_DIG * log10(2));
+}
+
+/******************** MCA ARITHMETIC FUNCTIONS ********************
+* The following set of functions perform the randomly rounded
+* operations. The result rounded to the nearest and its exact error
+* are computed with error-free transformations, then passed to
+* dround or fround with one random bit per sample.
+* The mode and the operator are compile time constants: each kernel
+* below is specialized for one of them and has no branch on either.
+*******************************************************************/
+
+// perform_bin_op: applies the binary operator (op) to (a) and (b)
+// and stores the result in (res)
+#define perform_bin_op(op, res, a, b)                               \
+    switch (op){                                                    \
+    case MCA_ADD: res=(a)+(b); break;                               \
+    case MCA_MUL: res=(a)*(b); break;                               \
+    case MCA_SUB: res=(a)-(b); break;                               \
+    case MCA_DIV: res=(a)/(b); break;                               \
+    default: perror("invalid operator in mcacestac.\n"); abort();   \
+	};
+
+// the samples are computed in the modes with outbound errors
+#define MCA_OUTBOUND(mode) ((mode) == MCAMODE_MCA || (mode) == MCAMODE_RR)
+
+/* one randomly rounded sample of a op b */
+static inline __attribute__((always_inline))
+float _mca_sround(float a, float b, const int op, uint64_t bit) {
+	float res = 0;
+	double err = 0;
+
+	switch (op){
+	case MCA_SUB:
+		b = -b;
+		/* fall through */
+	case MCA_ADD:
+		res = a + b;
+		err = fadd_error(a, b, res);
+		break;
+	case MCA_MUL:
+		res = a * b;
+		err = fmul_error(a, b, res);
+		break;
+	case MCA_DIV:
+		res = a / b;
+		err = fdiv_error(a, b, res);
+		break;
+	default: perror("invalid operator in mcacestac.\n"); abort();
+	};
+
+	return fround(res, err, bit);
+}
+
+static inline __attribute__((always_inline))
+double _mca_dround(double a, double b, const int op, uint64_t bit) {
+	double res = 0;
+	double err = 0;
+
+	switch (op){
+	case MCA_SUB:
+		b = -b;
+		/* fall through */
+	case MCA_ADD:
+		res = a + b;
+		err = dadd_error(a, b, res);
+		break;
+	case MCA_MUL:
+		res = a * b;
+		err = dmul_error(a, b, res);
+		break;
+	case MCA_DIV:
+		res = a / b;
+		err = ddiv_error(a, b, res);
+		break;
+	default: perror("invalid operator in mcacestac.\n"); abort();
+	};
+
+	return dround(res, err, bit);
+}
+
+static inline __attribute__((always_inline))
+float _mca_sbin(float a, float b, const int mode, const int op) {
+	float res = 0;
+
+	if (!MCA_OUTBOUND(mode)) {
+		perform_bin_op(op, res, a, b);
+		return res;
+	}
+
+	struct cestac_cache_t * cache = _cestac_cache();
+	float x[CESTAC_SAMPLES], y[CESTAC_SAMPLES], r[CESTAC_SAMPLES];
+	uint64_t bits = _mca_rand_bits();
+	int i;
+
+	_cestac_fload(cache, a, x);
+	_cestac_fload(cache, b, y);
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		r[i] = _mca_sround(x[i], y[i], op, bits & (UINT64_C(1) << i));
+	_cestac_fstore(cache, r);
+	return r[0];
+}
+
+static inline __attribute__((always_inline))
+double _mca_dbin(double a, double b, const int mode, const int op) {
+	double res = 0;
+
+	if (!MCA_OUTBOUND(mode)) {
+		perform_bin_op(op, res, a, b);
+		return res;
+	}
+
+	struct cestac_cache_t * cache = _cestac_cache();
+	double x[CESTAC_SAMPLES], y[CESTAC_SAMPLES], r[CESTAC_SAMPLES];
+	uint64_t bits = _mca_rand_bits();
+	int i;
+
+	_cestac_dload(cache, a, x);
+	_cestac_dload(cache, b, y);
+	for (i = 0; i < CESTAC_SAMPLES; i++)
+		r[i] = _mca_dround(x[i], y[i], op, bits & (UINT64_C(1) << i));
+	_cestac_dstore(cache, r);
+	return r[0];
+}
+
+/************************* FPHOOKS FUNCTIONS *************************
+* These functions correspond to those inserted into the source code
+* during source to source compilation and are replacement to floating
+* point operators. MCA_KERNELS defines them for one mode.
+**********************************************************************/
+
+#define MCA_KERNELS(MODE)                                               \
+static float _floatadd_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static float _floatsub_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+static float _floatmul_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+static float _floatdiv_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}                                                                       \
+static double _doubleadd_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static double _doublesub_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+VFC_FMA_TARGET_CLONES                                                   \
+static double _doublemul_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+VFC_FMA_TARGET_CLONES                                                   \
+static double _doublediv_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}
+
+MCA_KERNELS(IEEE)
+MCA_KERNELS(MCA)
+MCA_KERNELS(PB)
+MCA_KERNELS(RR)
+
+#define MCA_INTERFACE(MODE) {                                           \
+	.floatadd = _floatadd_##MODE,                                   \
+	.floatsub = _floatsub_##MODE,                                   \
+	.floatmul = _floatmul_##MODE,                                   \
+	.floatdiv = _floatdiv_##MODE,                                   \
+	.doubleadd = _doubleadd_##MODE,                                 \
+	.doublesub = _doublesub_##MODE,                                 \
+	.doublemul = _doublemul_##MODE,                                 \
+	.doublediv = _doublediv_##MODE,                                 \
+	.seed = _mca_seed,                                              \
+	.set_mca_mode = _set_mca_mode,                                  \
+	.set_mca_precision = _set_mca_precision,                        \
+	.floatdigits = _floatdigits,                                    \
+	.doubledigits = _doubledigits                                   \
+}
+
+/* vtables indexed by mode */
+static const struct mca_interface_t _mca_kernels[] = {
+	[MCAMODE_IEEE] = MCA_INTERFACE(IEEE),
+	[MCAMODE_MCA]  = MCA_INTERFACE(MCA),
+	[MCAMODE_PB]   = MCA_INTERFACE(PB),
+	[MCAMODE_RR]   = MCA_INTERFACE(RR),
+};
+
+struct mca_interface_t cestac_mca_interface = MCA_INTERFACE(IEEE);
+
+/* The wrapper copies cestac_mca_interface after setting the mode,
+ * so the instrumented code calls the kernels of that mode */
+static void _mca_select_kernels(int mode) {
+	cestac_mca_interface = _mca_kernels[mode];
+}
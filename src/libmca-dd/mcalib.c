@@ -0,0 +1,327 @@
+/********************************************************************************
+ *                                                                              *
+ *  This file is part of Verificarlo.                                           *
+ *                                                                              *
+ *  Copyright (c) 2026                                                          *
+ *     Universite de Versailles St-Quentin-en-Yvelines                          *
+ *     CMLA, Ecole Normale Superieure de Cachan                                 *
+ *                                                                              *
+ *  Verificarlo is free software: you can redistribute it and/or modify         *
+ *  it under the terms of the GNU General Public License as published by        *
+ *  the Free Software Foundation, either version 3 of the License, or           *
+ *  (at your option) any later version.                                         *
+ *                                                                              *
+ *  Verificarlo is distributed in the hope that it will be useful,              *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ *  GNU General Public License for more details.                                *
+ *                                                                              *
+ *  You should have received a copy of the GNU General Public License           *
+ *  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+ *                                                                              *
+ ********************************************************************************/
+
+
+// Changelog:
+//
+// 2026-10-19 Double-double backend
+//
+// Double operations are computed exactly, or to 106 bits, as an
+// unevaluated sum hi + lo of two doubles (vfc_eft.h), and the MCA noise
+// is injected in the low word. Single precision operations are performed
+// in double as in the QUAD backend.
+//
+// The noise of a double operand or result x is 2^(e_x - t) * r, with
+// r in (-0.5, 0.5). For t <= 53 its magnitude is at most half the
+// magnitude of x, so x + noise is exactly hi + lo. The final rounding
+// of hi + lo to the nearest double is the only rounding of an MCA
+// operation, as in the other backends.
+//
+// As in the QUAD backend, the kernels are specialized by mode and
+// operation, set_mca_mode installs the vtable of the selected mode.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "libmca-dd.h"
+#include "../vfcwrapper/vfcwrapper.h"
+#include "../common/vfc_eft.h"
+#include "../common/vfc_rng.h"
+#include "../common/mca_const.h"
+
+// virtual precision of each mode, published with the kernels of the mode
+// by _set_mca_mode as in the QUAD backend
+static int 	MCALIB_T_NEXT		    = 53;
+static int 	MCALIB_T[MCAMODE_RR + 1]    = { 53, 53, 53, 53 };
+
+//possible op values
+#define MCA_ADD 1
+#define MCA_SUB 2
+#define MCA_MUL 3
+#define MCA_DIV 4
+
+static void _mca_select_kernels(int mode);
+
+/******************** MCA CONTROL FUNCTIONS *******************
+* The following functions are used to set virtual precision and
+* MCA mode of operation.
+***************************************************************/
+
+static int _set_mca_mode(int mode){
+	if (mode < 0 || mode > 3)
+		return -1;
+
+	__atomic_store_n(&MCALIB_T[mode], MCALIB_T_NEXT, __ATOMIC_RELEASE);
+	_mca_select_kernels(mode);
+	return 0;
+}
+
+static int _set_mca_precision(int precision){
+	MCALIB_T_NEXT = precision;
+	return 0;
+}
+
+/******************** MCA RANDOM FUNCTIONS ********************
+* The following functions are used to calculate the random
+* perturbations used for MCA
+***************************************************************/
+
+static double _mca_rand(void) {
+	/* Returns a random double in the (0,1) open interval */
+	return vfc_rng_doubleOO();
+}
+
+static inline double pow2d(int exp) {
+  union {
+    uint64_t u;
+    double d;
+  } x;
+
+  //specials
+  if (exp == 0) return 1;
+
+  if (exp > 1023) { /*exceed max exponent*/
+	x.u = DOUBLE_PLUS_INF;
+	return x.d;
+  }
+  if (exp < -1022) { /*subnormal*/
+	x.u = ((uint64_t) DOUBLE_PMAN_MSB ) >> -(exp+DOUBLE_EXP_MAX);
+	return x.d;
+  }
+
+  //normal case
+  //complement the exponent, shift it at the right place in the MSW
+  x.u = ( ((uint64_t) exp) + DOUBLE_EXP_COMP) << DOUBLE_PMAN_SIZE;
+  return x.d;
+}
+
+static inline int32_t rexpd (double x)
+{
+  //no need to check special value in our cases since pow2d will deal with it
+  //do not reuse it outside this code!
+  union {
+    uint64_t u;
+    double d;
+  } hex = { .d = x };
+  //remove sign bit and shift exponent to have LSB on position 0, complement
+  return (int32_t) ((hex.u & DOUBLE_ERASE_SIGN) >> DOUBLE_PMAN_SIZE) - DOUBLE_EXP_COMP;
+}
+
+/* Returns the MCA noise for a value of exponent e_a */
+static inline double dnoise(int32_t e_a, int t) {
+	return pow2d(e_a - t) * (_mca_rand() - 0.5);
+}
+
+/* zeros are not perturbed, as in the QUAD and MPFR backends */
+static void _mca_inexactd(double *da, int t) {
+	if (*da == 0) {
+		return;
+	}
+	*da = *da + dnoise(rexpd(*da), t);
+}
+
+static void _mca_seed(const struct vfc_rng_config_t *config) {
+	/* Each thread derives its own stream from the configuration */
+	vfc_rng_seed(config, MCABACKEND_DD);
+}
+
+/* Returns the double-double a + noise, a if it is zero */
+static inline dd_t dd_inexact(double a, int t) {
+	if (a == 0) {
+		dd_t z = { a, 0 };
+		return z;
+	}
+	return fast_two_sum(a, dnoise(rexpd(a), t));
+}
+
+/******************** MCA ARITHMETIC FUNCTIONS ********************
+* The following set of functions perform the MCA operation. Float
+* operands are converted to double, double operands to double-double,
+* inbound and outbound perturbations are applied using the
+* _mca_inexact functions, and the result is rounded to the original
+* format for return.
+* The mode and the operator are compile time constants: each kernel
+* below is specialized for one of them and has no branch on either.
+*******************************************************************/
+
+// perform_bin_op: applies the binary operator (op) to (a) and (b)
+// and stores the result in (res)
+#define perform_bin_op(op, res, a, b)                               \
+    switch (op){                                                    \
+    case MCA_ADD: res=(a)+(b); break;                               \
+    case MCA_MUL: res=(a)*(b); break;                               \
+    case MCA_SUB: res=(a)-(b); break;                               \
+    case MCA_DIV: res=(a)/(b); break;                               \
+    default: perror("invalid operator in mcadd.\n"); abort();       \
+	};
+
+// inbound and outbound perturbations of each mode
+#define MCA_INBOUND(mode)  ((mode) == MCAMODE_MCA || (mode) == MCAMODE_PB)
+#define MCA_OUTBOUND(mode) ((mode) == MCAMODE_MCA || (mode) == MCAMODE_RR)
+
+// MCA_PRECISION: the virtual precision of the mode, read once by each
+// operation
+#define MCA_PRECISION(mode)                                                \
+	((mode) == MCAMODE_IEEE ? 0 : __atomic_load_n(&MCALIB_T[mode], __ATOMIC_RELAXED))
+
+static inline __attribute__((always_inline))
+float _mca_sbin(float a, float b, const int mode, const int dop) {
+	double da = (double)a;
+	double db = (double)b;
+
+	double res = 0;
+	const int t = MCA_PRECISION(mode);
+
+	if (MCA_INBOUND(mode)) {
+		_mca_inexactd(&da, t);
+		_mca_inexactd(&db, t);
+	}
+
+    perform_bin_op(dop, res, da, db);
+
+	if (MCA_OUTBOUND(mode)) {
+		_mca_inexactd(&res, t);
+	}
+
+	return ((float)res);
+}
+
+static inline __attribute__((always_inline))
+double _mca_dbin(double a, double b, const int mode, const int qop) {
+	double res = 0;
+
+	/* IEEE mode and special values are not perturbed. The error-free
+	 * transformations turn an infinite result into inf - inf: overflows
+	 * and divisions by zero return the native result */
+	perform_bin_op(qop, res, a, b);
+	if (mode == MCAMODE_IEEE || !isfinite(res)) {
+		return res;
+	}
+
+	const int t = MCA_PRECISION(mode);
+	dd_t da = { a, 0 };
+	dd_t db = { b, 0 };
+	dd_t dres;
+
+	if (MCA_INBOUND(mode)) {
+		da = dd_inexact(a, t);
+		db = dd_inexact(b, t);
+	}
+
+	switch (qop){
+	case MCA_ADD: dres = dd_add(da, db); break;
+	case MCA_SUB: dres = dd_add(da, dd_neg(db)); break;
+	case MCA_MUL: dres = dd_mul(da, db); break;
+	case MCA_DIV: dres = dd_div(da, db); break;
+	default: perror("invalid operator in mcadd.\n"); abort();
+	};
+
+	/* the perturbed operation overflows: its native result is infinite */
+	if (!isfinite(dres.hi)) {
+		perform_bin_op(qop, res, da.hi, db.hi);
+		return res;
+	}
+
+	/* an exact zero result is not perturbed */
+	if (MCA_OUTBOUND(mode) && dres.hi != 0) {
+		/* hi + lo + noise rounded to the nearest double */
+		dd_t s = fast_two_sum(dres.hi, dnoise(rexpd(dres.hi), t));
+		if (!isfinite(s.hi))
+			return s.hi;
+		return s.hi + (s.lo + dres.lo);
+	}
+
+	return dres.hi + dres.lo;
+}
+
+/************************* FPHOOKS FUNCTIONS *************************
+* These functions correspond to those inserted into the source code
+* during source to source compilation and are replacement to floating
+* point operators. MCA_KERNELS defines them for one mode.
+**********************************************************************/
+
+#define MCA_KERNELS(MODE)                                               \
+static float _floatadd_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static float _floatsub_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+static float _floatmul_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+static float _floatdiv_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}                                                                       \
+static double _doubleadd_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static double _doublesub_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+VFC_FMA_TARGET_CLONES                                                   \
+static double _doublemul_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+VFC_FMA_TARGET_CLONES                                                   \
+static double _doublediv_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}
+
+MCA_KERNELS(IEEE)
+MCA_KERNELS(MCA)
+MCA_KERNELS(PB)
+MCA_KERNELS(RR)
+
+#define MCA_INTERFACE(MODE) {                                           \
+	_floatadd_##MODE,                                               \
+	_floatsub_##MODE,                                               \
+	_floatmul_##MODE,                                               \
+	_floatdiv_##MODE,                                               \
+	_doubleadd_##MODE,                                              \
+	_doublesub_##MODE,                                              \
+	_doublemul_##MODE,                                              \
+	_doublediv_##MODE,                                              \
+	_mca_seed,                                                      \
+	_set_mca_mode,                                                  \
+	_set_mca_precision                                              \
+}
+
+/* vtables indexed by mode */
+static const struct mca_interface_t _mca_kernels[] = {
+	[MCAMODE_IEEE] = MCA_INTERFACE(IEEE),
+	[MCAMODE_MCA]  = MCA_INTERFACE(MCA),
+	[MCAMODE_PB]   = MCA_INTERFACE(PB),
+	[MCAMODE_RR]   = MCA_INTERFACE(RR),
+};
+
+struct mca_interface_t dd_mca_interface = MCA_INTERFACE(IEEE);
+
+/* The wrapper copies dd_mca_interface after setting the mode,
+ * so the instrumented code calls the kernels of that mode */
+static void _mca_select_kernels(int mode) {
+	dd_mca_interface = _mca_kernels[mode];
+}
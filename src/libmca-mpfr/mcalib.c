@@ -18,6 +18,21 @@
 // 2015-11-14 remove effectless comparison functions, llvm will not 
 // instrument it.
 //
+// 2026-10-19 Per-thread random streams derived from the seed, sample and
+// thread, see vfc_rng.h
+//
+// 2026-10-19 Per-thread pool of MPFR operands, resized only when the
+// virtual precision changes: operations no longer allocate.
+//
+// 2026-10-19 The noise is a random 64-bit integer scaled by a power of
+// two in a single exact MPFR call, instead of a product of two doubles
+// converted to MPFR: pow() is no longer called and zeros, infinities and
+// NaNs are skipped before reading the exponent.
+//
+// 2026-10-19 REF mode: operations are computed without noise at the
+// virtual precision, and each result keeps its high precision value in a
+// per-thread shadow cache where the next operations read their operands.
+//
 // This file is part of the Monte Carlo Arithmetic Library, (MCALIB). MCALIB is
 // free software: you can redistribute it and/or modify it under the terms of
 // the GNU General Public License as published by the Free Software Foundation,
@@ -31,21 +46,26 @@
 // You should have received a copy of the GNU General Public License along with
 // this program.  If not, see <http://www.gnu.org/licenses/>.
 
-#include <math.h>
+#include <stdint.h>
 #include <mpfr.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
-#include <unistd.h>
 
 #include "libmca-mpfr.h"
 #include "../vfcwrapper/vfcwrapper.h"
-#include "../common/tinymt64.h"
+#include "../common/vfc_rng.h"
 #include "../common/mca_const.h"
 
 
+// mode, and virtual precision of each mode. _set_mca_precision keeps the
+// precision in MCALIB_T_NEXT until _set_mca_mode publishes it with the
+// mode: an operation reads the mode once, then the precision of that mode,
+// and never mixes the precision of one configuration with the mode of
+// another
 static int 	MCALIB_OP_TYPE 		= MCAMODE_IEEE;
-static int 	MCALIB_T		    = 53;
+static int 	MCALIB_T_NEXT		    = 53;
+static int 	MCALIB_T[MCAMODE_REF + 1]   = { 53, 53, 53, 53, 53 };
 
 #define MP_ADD &mpfr_add
 #define MP_SUB &mpfr_sub
@@ -53,29 +73,62 @@ static int 	MCALIB_T		    = 53;
 #define MP_DIV &mpfr_div
 
 typedef int (*mpfr_bin)(mpfr_t, mpfr_t, mpfr_t, mpfr_rnd_t);
-typedef int (*mpfr_unr)(mpfr_t, mpfr_t, mpfr_rnd_t);
+
+/* MPFR operands of one type, all of precision prec */
+struct mca_operands {
+	mpfr_prec_t prec;
+	mpfr_t a, b, r, rand;
+};
+
+/* high precision value of a float or double result in REF mode */
+struct mca_shadow {
+	uint64_t key;                   /* bits of the float or double result */
+	int init;                       /* x is initialized */
+	mpfr_t x;
+};
+
+// each thread keeps the high precision values of the last
+// 2^MCA_SHADOW_BITS results of each type in REF mode
+#define MCA_SHADOW_BITS 16
+#define MCA_SHADOW_SIZE (1 << MCA_SHADOW_BITS)
+
+struct mca_shadows {
+	uint64_t generation;            /* _mca_shadow_generation when allocated */
+	struct mca_shadow f[MCA_SHADOW_SIZE];
+	struct mca_shadow d[MCA_SHADOW_SIZE];
+};
+
+/* per-thread operands of the float and double operations */
+struct mca_pool {
+	struct mca_operands f, d;
+	struct mca_shadows *shadows;    /* NULL until the first REF operation */
+};
 
 static float _mca_sbin(float a, float b, mpfr_bin mpfr_op);
-static float _mca_sunr(float a, mpfr_unr mpfr_op);
 
 static double _mca_dbin(double a, double b, mpfr_bin mpfr_op);
-static double _mca_dunr(double a, mpfr_unr mpfr_op);
 
 /******************** MCA CONTROL FUNCTIONS *******************
 * The following functions are used to set virtual precision and
 * MCA mode of operation.
 ***************************************************************/
 
+/* incremented when the mode or the precision are published, to drop the shadow
+ * values computed with the previous configuration */
+static uint64_t _mca_shadow_generation = 0;
+
 static int _set_mca_mode(int mode){
-	if (mode < 0 || mode > 3)
+	if (mode < 0 || mode > MCAMODE_REF)
 		return -1;
 
-	MCALIB_OP_TYPE = mode;
+	__atomic_store_n(&MCALIB_T[mode], MCALIB_T_NEXT, __ATOMIC_RELEASE);
+	__atomic_store_n(&MCALIB_OP_TYPE, mode, __ATOMIC_RELEASE);
+	__atomic_add_fetch(&_mca_shadow_generation, 1, __ATOMIC_RELEASE);
 	return 0;
 }
 
 static int _set_mca_precision(int precision){
-	MCALIB_T = precision;
+	MCALIB_T_NEXT = precision;
 	return 0;
 }
 
@@ -86,56 +139,224 @@ static int _set_mca_precision(int precision){
 * operands
 ***************************************************************/
 
-/* random generator internal state */
-static tinymt64_t random_state;
-
-static double _mca_rand(void) {
-	/* Returns a random double in the (0,1) open interval */
-	return tinymt64_generate_doubleOO(&random_state);
+static int64_t _mca_rand(void) {
+	/* Returns a random integer uniformly distributed in [-2^63, 2^63) */
+	return (int64_t) vfc_rng_uint64();
 }
 
-static int _mca_inexact(mpfr_ptr a, mpfr_rnd_t rnd_mode) {
-	if (MCALIB_OP_TYPE == MCAMODE_IEEE) {
+/* Perturbs a, one of the operands of ops, with a random noise uniformly
+ * distributed in [-1/2, 1/2) * 2^(e - t), where a is in [2^e, 2^(e+1)) */
+static int _mca_inexact(mpfr_ptr a, struct mca_operands *ops, int mode, int t,
+			mpfr_rnd_t rnd_mode) {
+	if (mode == MCAMODE_IEEE) {
+		return 0;
+	}
+	/* zeros, infinities and NaNs are not perturbed */
+	if (!mpfr_regular_p(a)) {
 		return 0;
 	}
 	//get_exp reproduce frexp behavior, i.e. exp corresponding to a normalization in the interval [1/2 1[
 	//remove one to normalize in [1 2[ like ieee numbers
 	mpfr_exp_t e_a = mpfr_get_exp(a)-1;
-	mpfr_prec_t p_a = mpfr_get_prec(a);
-	mpfr_t mpfr_rand, mpfr_offset, mpfr_zero;
-	e_a = e_a - MCALIB_T;
-	mpfr_inits2(p_a, mpfr_rand, mpfr_offset, mpfr_zero, (mpfr_ptr) 0);
-	mpfr_set_d(mpfr_zero, 0., rnd_mode);
-	int cmp = mpfr_cmp(a, mpfr_zero);
-	if (cmp == 0) {
-		mpfr_clear(mpfr_rand);
-		mpfr_clear(mpfr_offset);
-		mpfr_clear(mpfr_zero);
-		return 0;
+	e_a = e_a - t;
+	/* the noise is rand * 2^(e_a - 64), rounded to the precision of a */
+	mpfr_set_sj_2exp(ops->rand, _mca_rand(), e_a - 64, rnd_mode);
+	mpfr_add(a, a, ops->rand, rnd_mode);
+	return 0;
+}
+
+static void _mca_seed(const struct vfc_rng_config_t *config) {
+	/* Each thread derives its own stream from the configuration */
+	vfc_rng_seed(config, MCABACKEND_MPFR);
+}
+
+/******************** MCA OPERANDS POOL ***********************
+* Each thread keeps the MPFR operands of its operations from one
+* call to the next. They are only reallocated when the virtual
+* precision changes, and freed when the thread exits. As for the
+* random streams, only the address of the pool is thread local.
+***************************************************************/
+
+static pthread_key_t _mca_pool_key;
+static pthread_once_t _mca_pool_once = PTHREAD_ONCE_INIT;
+static __thread struct mca_pool * _mca_pool_local
+	__attribute__((tls_model("initial-exec")));
+
+static void _mca_operands_init(struct mca_operands *ops, mpfr_prec_t prec) {
+	ops->prec = prec;
+	mpfr_inits2(prec, ops->a, ops->b, ops->r, ops->rand, (mpfr_ptr) 0);
+}
+
+static void _mca_operands_clear(struct mca_operands *ops) {
+	mpfr_clears(ops->a, ops->b, ops->r, ops->rand, (mpfr_ptr) 0);
+}
+
+static void _mca_shadows_free(struct mca_shadows *shadows) {
+	int i;
+
+	if (shadows == NULL)
+		return;
+	for (i = 0; i < MCA_SHADOW_SIZE; i++) {
+		if (shadows->f[i].init)
+			mpfr_clear(shadows->f[i].x);
+		if (shadows->d[i].init)
+			mpfr_clear(shadows->d[i].x);
 	}
-	double d_rand = (_mca_rand() - 0.5);
-	double d_offset = pow(2, e_a);
-	mpfr_set_d(mpfr_rand, d_rand, rnd_mode);
-	mpfr_set_d(mpfr_offset, d_offset, rnd_mode);
-	mpfr_mul(mpfr_rand, mpfr_rand, mpfr_offset, rnd_mode);
-	mpfr_add(a, a, mpfr_rand, rnd_mode);
-	mpfr_clear(mpfr_rand);
-	mpfr_clear(mpfr_offset);
-	mpfr_clear(mpfr_zero);
+	free(shadows);
 }
 
-static void _mca_seed(void) {
-	const int key_length = 3;
-	uint64_t init_key[key_length];
-	struct timeval t1;
-	gettimeofday(&t1, NULL);
+/* releases the pool of an exiting thread */
+static void _mca_pool_free(void *p) {
+	struct mca_pool *pool = p;
+	_mca_pool_local = NULL;
+	_mca_operands_clear(&pool->f);
+	_mca_operands_clear(&pool->d);
+	_mca_shadows_free(pool->shadows);
+	free(pool);
+}
 
-	/* Hopefully the following seed is good enough for Montercarlo */
-	init_key[0] = t1.tv_sec;
-	init_key[1] = t1.tv_usec;
-	init_key[2] = getpid();
+static void _mca_pool_init_once(void) {
+	pthread_key_create(&_mca_pool_key, _mca_pool_free);
+}
 
-	tinymt64_init_by_array(&random_state, init_key, key_length);
+static struct mca_pool * __attribute__((noinline)) _mca_pool_new(void) {
+	struct mca_pool *pool = malloc(sizeof(struct mca_pool));
+	if (pool == NULL) {
+		perror("mcampfr: cannot allocate the thread operands");
+		abort();
+	}
+	/* resized by the first operation if needed */
+	_mca_operands_init(&pool->f, FLOAT_PREC);
+	_mca_operands_init(&pool->d, DOUBLE_PREC);
+	pool->shadows = NULL;
+	pthread_once(&_mca_pool_once, _mca_pool_init_once);
+	pthread_setspecific(_mca_pool_key, pool);
+	_mca_pool_local = pool;
+	return pool;
+}
+
+static void __attribute__((noinline)) _mca_operands_resize(struct mca_operands *ops,
+							   mpfr_prec_t prec) {
+	_mca_operands_clear(ops);
+	_mca_operands_init(ops, prec);
+}
+
+/* Returns the operands of the calling thread at precision prec. f selects
+ * the float or the double operands. */
+static inline struct mca_operands * _mca_operands(int f, mpfr_prec_t prec) {
+	struct mca_pool *pool = _mca_pool_local;
+	if (__builtin_expect(pool == NULL, 0))
+		pool = _mca_pool_new();
+	struct mca_operands *ops = f ? &pool->f : &pool->d;
+	if (__builtin_expect(ops->prec != prec, 0))
+		_mca_operands_resize(ops, prec);
+	return ops;
+}
+
+/******************** REF MODE SHADOW VALUES ******************
+* In REF mode the operations are computed at t bits without
+* noise. The program only carries the float or double rounding of
+* each result: its high precision value is kept in a direct mapped
+* cache indexed by a hash of the rounded bits, where the operands of
+* the next operations find it. An operand absent from the cache (a
+* constant, a value computed by code that is not instrumented, or an
+* entry evicted by a collision) is taken at its float or double value.
+* The entries allocate their limbs on first use only.
+***************************************************************/
+
+/* Returns the shadow cache of the calling thread */
+static struct mca_shadows * _mca_shadows(void) {
+	struct mca_pool *pool = _mca_pool_local;
+	if (__builtin_expect(pool == NULL, 0))
+		pool = _mca_pool_new();
+	struct mca_shadows *shadows = pool->shadows;
+	uint64_t generation = __atomic_load_n(&_mca_shadow_generation, __ATOMIC_ACQUIRE);
+	if (__builtin_expect(shadows == NULL || shadows->generation != generation, 0)) {
+		_mca_shadows_free(shadows);
+		shadows = calloc(1, sizeof(struct mca_shadows));
+		if (shadows == NULL) {
+			perror("mcampfr: cannot allocate the thread shadow values");
+			abort();
+		}
+		shadows->generation = generation;
+		pool->shadows = shadows;
+	}
+	return shadows;
+}
+
+static inline struct mca_shadow * _mca_shadow(struct mca_shadow *table, uint64_t key) {
+	return &table[(key * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - MCA_SHADOW_BITS)];
+}
+
+/* Returns the high precision value of the result whose rounding has the
+ * bits key, or NULL if it is not cached. The value of the opposite of a
+ * cached result is its opposite, negations are not instrumented: tmp
+ * receives it. */
+static mpfr_ptr _mca_shadow_load(struct mca_shadow *table, uint64_t key,
+				 uint64_t sign, mpfr_ptr tmp) {
+	struct mca_shadow *e = _mca_shadow(table, key);
+	if (e->init && e->key == key)
+		return e->x;
+	e = _mca_shadow(table, key ^ sign);
+	if (e->init && e->key == (key ^ sign)) {
+		mpfr_neg(tmp, e->x, MPFR_RNDN);
+		return tmp;
+	}
+	return NULL;
+}
+
+static void _mca_shadow_store(struct mca_shadow *table, uint64_t key, mpfr_ptr x) {
+	struct mca_shadow *e = _mca_shadow(table, key);
+	if (!e->init) {
+		mpfr_init2(e->x, mpfr_get_prec(x));
+		e->init = 1;
+	}
+	e->key = key;
+	mpfr_set(e->x, x, MPFR_RNDN);
+}
+
+static float _mca_sref(float a, float b, int t, mpfr_bin mpfr_op) {
+	struct mca_operands *ops = _mca_operands(1, t);
+	struct mca_shadows *shadows = _mca_shadows();
+	union { float f; uint32_t u; } ha = { a }, hb = { b }, hr;
+	mpfr_rnd_t rnd = MPFR_RNDN;
+
+	mpfr_ptr x = _mca_shadow_load(shadows->f, ha.u, UINT32_C(1) << 31, ops->a);
+	if (x == NULL) {
+		mpfr_set_flt(ops->a, a, rnd);
+		x = ops->a;
+	}
+	mpfr_ptr y = _mca_shadow_load(shadows->f, hb.u, UINT32_C(1) << 31, ops->b);
+	if (y == NULL) {
+		mpfr_set_flt(ops->b, b, rnd);
+		y = ops->b;
+	}
+	mpfr_op(ops->r, x, y, rnd);
+	hr.f = mpfr_get_flt(ops->r, rnd);
+	_mca_shadow_store(shadows->f, hr.u, ops->r);
+	return hr.f;
+}
+
+static double _mca_dref(double a, double b, int t, mpfr_bin mpfr_op) {
+	struct mca_operands *ops = _mca_operands(0, t);
+	struct mca_shadows *shadows = _mca_shadows();
+	union { double d; uint64_t u; } ha = { a }, hb = { b }, hr;
+	mpfr_rnd_t rnd = MPFR_RNDN;
+
+	mpfr_ptr x = _mca_shadow_load(shadows->d, ha.u, UINT64_C(1) << 63, ops->a);
+	if (x == NULL) {
+		mpfr_set_d(ops->a, a, rnd);
+		x = ops->a;
+	}
+	mpfr_ptr y = _mca_shadow_load(shadows->d, hb.u, UINT64_C(1) << 63, ops->b);
+	if (y == NULL) {
+		mpfr_set_d(ops->b, b, rnd);
+		y = ops->b;
+	}
+	mpfr_op(ops->r, x, y, rnd);
+	hr.d = mpfr_get_d(ops->r, rnd);
+	_mca_shadow_store(shadows->d, hr.u, ops->r);
+	return hr.d;
 }
 
 /******************** MCA ARITHMETIC FUNCTIONS ********************
@@ -146,84 +367,46 @@ static void _mca_seed(void) {
 *******************************************************************/
 
 static float _mca_sbin(float a, float b, mpfr_bin mpfr_op) {
-	mpfr_t mpfr_a, mpfr_b, mpfr_r;
-	mpfr_prec_t prec = FLOAT_PREC + MCALIB_T;
-	mpfr_rnd_t rnd = MPFR_RNDN;
-	mpfr_inits2(prec, mpfr_a, mpfr_b, mpfr_r, (mpfr_ptr) 0);
-	mpfr_set_flt(mpfr_a, a, rnd);
-	mpfr_set_flt(mpfr_b, b, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_RR) {
-		_mca_inexact(mpfr_a, rnd);
-		_mca_inexact(mpfr_b, rnd);
+	int mode = __atomic_load_n(&MCALIB_OP_TYPE, __ATOMIC_ACQUIRE);
+	int t = __atomic_load_n(&MCALIB_T[mode], __ATOMIC_RELAXED);
+	if (mode == MCAMODE_REF) {
+		return _mca_sref(a, b, t, mpfr_op);
 	}
-	mpfr_op(mpfr_r, mpfr_a, mpfr_b, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_PB) {
-		_mca_inexact(mpfr_r, rnd);
-	}
-	float ret = mpfr_get_flt(mpfr_r, rnd);
-	mpfr_clear(mpfr_a);
-	mpfr_clear(mpfr_b);
-	mpfr_clear(mpfr_r);
-	return NEAREST_FLOAT(ret);
-}
-
-static float _mca_sunr(float a, mpfr_unr mpfr_op) {
-	mpfr_t mpfr_a, mpfr_r;
-	mpfr_prec_t prec = FLOAT_PREC + MCALIB_T;
+	struct mca_operands *ops = _mca_operands(1, FLOAT_PREC + t);
 	mpfr_rnd_t rnd = MPFR_RNDN;
-	mpfr_inits2(prec, mpfr_a, mpfr_r, (mpfr_ptr) 0);
-	mpfr_set_flt(mpfr_a, a, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_RR) {
-		_mca_inexact(mpfr_a, rnd);
+	mpfr_set_flt(ops->a, a, rnd);
+	mpfr_set_flt(ops->b, b, rnd);
+	if (mode != MCAMODE_RR) {
+		_mca_inexact(ops->a, ops, mode, t, rnd);
+		_mca_inexact(ops->b, ops, mode, t, rnd);
 	}
-	mpfr_op(mpfr_r, mpfr_a, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_PB) {
-		_mca_inexact(mpfr_r, rnd);
+	mpfr_op(ops->r, ops->a, ops->b, rnd);
+	if (mode != MCAMODE_PB) {
+		_mca_inexact(ops->r, ops, mode, t, rnd);
 	}
-	float ret = mpfr_get_flt(mpfr_r, rnd);
-	mpfr_clear(mpfr_a);
-	mpfr_clear(mpfr_r);
+	float ret = mpfr_get_flt(ops->r, rnd);
 	return NEAREST_FLOAT(ret);
 }
 
 static double _mca_dbin(double a, double b, mpfr_bin mpfr_op) {
-	mpfr_t mpfr_a, mpfr_b, mpfr_r;
-	mpfr_prec_t prec = DOUBLE_PREC + MCALIB_T;
-	mpfr_rnd_t rnd = MPFR_RNDN;
-	mpfr_inits2(prec, mpfr_a, mpfr_b, mpfr_r, (mpfr_ptr) 0);
-	mpfr_set_d(mpfr_a, a, rnd);
-	mpfr_set_d(mpfr_b, b, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_RR) {
-		_mca_inexact(mpfr_a, rnd);
-		_mca_inexact(mpfr_b, rnd);
+	int mode = __atomic_load_n(&MCALIB_OP_TYPE, __ATOMIC_ACQUIRE);
+	int t = __atomic_load_n(&MCALIB_T[mode], __ATOMIC_RELAXED);
+	if (mode == MCAMODE_REF) {
+		return _mca_dref(a, b, t, mpfr_op);
 	}
-	mpfr_op(mpfr_r, mpfr_a, mpfr_b, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_PB) {
-		_mca_inexact(mpfr_r, rnd);
-	}
-	double ret = mpfr_get_d(mpfr_r, rnd);
-	mpfr_clear(mpfr_a);
-	mpfr_clear(mpfr_b);
-	mpfr_clear(mpfr_r);
-	return NEAREST_DOUBLE(ret);
-}
-
-static double _mca_dunr(double a, mpfr_unr mpfr_op) {
-	mpfr_t mpfr_a, mpfr_r;
-	mpfr_prec_t prec = DOUBLE_PREC + MCALIB_T;
+	struct mca_operands *ops = _mca_operands(0, DOUBLE_PREC + t);
 	mpfr_rnd_t rnd = MPFR_RNDN;
-	mpfr_inits2(prec, mpfr_a, mpfr_r, (mpfr_ptr) 0);
-	mpfr_set_d(mpfr_a, a, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_RR) {
-		_mca_inexact(mpfr_a, rnd);
+	mpfr_set_d(ops->a, a, rnd);
+	mpfr_set_d(ops->b, b, rnd);
+	if (mode != MCAMODE_RR) {
+		_mca_inexact(ops->a, ops, mode, t, rnd);
+		_mca_inexact(ops->b, ops, mode, t, rnd);
 	}
-	mpfr_op(mpfr_r, mpfr_a, rnd);
-	if (MCALIB_OP_TYPE != MCAMODE_PB) {
-		_mca_inexact(mpfr_r, rnd);
+	mpfr_op(ops->r, ops->a, ops->b, rnd);
+	if (mode != MCAMODE_PB) {
+		_mca_inexact(ops->r, ops, mode, t, rnd);
 	}
-	double ret = mpfr_get_d(mpfr_r, rnd);
-	mpfr_clear(mpfr_a);
-	mpfr_clear(mpfr_r);
+	double ret = mpfr_get_d(ops->r, rnd);
 	return NEAREST_DOUBLE(ret);
 }
 
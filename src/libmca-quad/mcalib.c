@@ -37,22 +37,38 @@
 //
 // 2017-04-25 Rewrite debug and validate the noise addition operation
 //
+// 2026-10-19 Per-thread random streams derived from the seed, sample and
+// thread, see vfc_rng.h
+//
+// 2026-10-19 Allocation-free pow2d, it leaked one word per float operation
+//
+// 2026-10-19 Kernels specialized by mode and operation, set_mca_mode
+// installs the vtable of the selected mode
+//
+// 2026-10-19 qnoise moves the fields of the random double directly to the
+// quad words, the special exponents are handled out of line
+//
+// 2026-10-19 Vector float kernels, compiled for AVX2 and AVX-512
+//
+// 2026-10-19 Zeros are not perturbed, 1/0 no longer has a random sign
+//
 
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
-#include <unistd.h>
 #include <stdint.h>
 
 #include "../common/quadmath-imp.h"
 #include "libmca-quad.h"
 #include "../vfcwrapper/vfcwrapper.h"
-#include "../common/tinymt64.h"
+#include "../common/vfc_rng.h"
 #include "../common/mca_const.h"
 
-static int 	MCALIB_OP_TYPE 		= MCAMODE_IEEE;
-static int 	MCALIB_T		    = 53;
+// virtual precision of each mode. _set_mca_precision keeps the precision
+// in MCALIB_T_NEXT until _set_mca_mode publishes it with the kernels of
+// the mode, so that a kernel never runs with the precision of another mode
+static int 	MCALIB_T_NEXT		    = 53;
+static int 	MCALIB_T[MCAMODE_RR + 1]    = { 53, 53, 53, 53 };
 
 //possible op values
 #define MCA_ADD 1
@@ -61,9 +77,23 @@ static int 	MCALIB_T		    = 53;
 #define MCA_DIV 4
 
 
-static float _mca_sbin(float a, float b, int qop);
+static void _mca_select_kernels(int mode);
 
-static double _mca_dbin(double a, double b, int qop);
+// The vector kernels are compiled for AVX-512, AVX2 and the baseline
+// x86-64 instruction set; the loader selects the clone matching the CPU.
+#if defined(__x86_64__) && defined(__has_attribute)
+#if __has_attribute(target_clones)
+#define QUAD_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#endif
+#endif
+#ifndef QUAD_TARGET_CLONES
+#define QUAD_TARGET_CLONES
+#endif
+
+// number of lanes computed at once by the vector kernels, shorter
+// vectors are faster through the scalar kernel
+#define MCA_VECTOR_LANES 16
+#define MCA_VECTOR_MIN   8
 
 /******************** MCA CONTROL FUNCTIONS *******************
 * The following functions are used to set virtual precision and
@@ -74,12 +104,13 @@ static int _set_mca_mode(int mode){
 	if (mode < 0 || mode > 3)
 		return -1;
 
-	MCALIB_OP_TYPE = mode;
+	__atomic_store_n(&MCALIB_T[mode], MCALIB_T_NEXT, __ATOMIC_RELEASE);
+	_mca_select_kernels(mode);
 	return 0;
 }
 
 static int _set_mca_precision(int precision){
-	MCALIB_T = precision;
+	MCALIB_T_NEXT = precision;
 	return 0;
 }
 
@@ -88,37 +119,34 @@ static int _set_mca_precision(int precision){
 * perturbations used for MCA 
 ***************************************************************/
 
-/* random generator internal state */
-static tinymt64_t random_state;
-
 static double _mca_rand(void) {
 	/* Returns a random double in the (0,1) open interval */
-	return tinymt64_generate_doubleOO(&random_state);
+	return vfc_rng_doubleOO();
 }
 
 static inline double pow2d(int exp) {
-  double res=0;
-  uint64_t *x=malloc(sizeof(uint64_t));
+  //build the result in a local, no allocation on the hot path
+  union {
+    uint64_t u;
+    double d;
+  } x;
 
   //specials
   if (exp == 0) return 1;
 
   if (exp > 1023) { /*exceed max exponent*/
-	*x= DOUBLE_PLUS_INF;
-  	res=*((double*)x);
-	return res;
+	x.u = DOUBLE_PLUS_INF;
+	return x.d;
   }
   if (exp < -1022) { /*subnormal*/
-        *x=((uint64_t) DOUBLE_PMAN_MSB ) >> -(exp+DOUBLE_EXP_MAX);
-	res=*((double*)x);
-        return res;
-}
+	x.u = ((uint64_t) DOUBLE_PMAN_MSB ) >> -(exp+DOUBLE_EXP_MAX);
+	return x.d;
+  }
 
   //normal case
   //complement the exponent, shift it at the right place in the MSW
-  *x=( ((uint64_t) exp) + DOUBLE_EXP_COMP) << DOUBLE_PMAN_SIZE;
-  res=*((double*)x);
-  return res;
+  x.u = ( ((uint64_t) exp) + DOUBLE_EXP_COMP) << DOUBLE_PMAN_SIZE;
+  return x.d;
 }
 
 static inline uint32_t rexpq (__float128 x)
@@ -150,119 +178,145 @@ static inline uint32_t rexpd (double x)
   return exp;
 }
 
-__float128 qnoise(int exp){
-  double d_rand = (_mca_rand() - 0.5);
-  uint64_t u_rand= *((uint64_t*) &d_rand);
+//cold path of qnoise: exp == 0, infinite and subnormal noises
+static __float128 __attribute__((noinline, cold)) qnoise_special(int exp, uint64_t u_rand){
   __float128 noise;
-  uint64_t hx, lx;
-  //specials
+
   if (exp == 0) return 1;
 
   if (exp > QUAD_EXP_MAX) { /*exceed max exponent*/
 	SET_FLT128_WORDS64(noise, QINF_hx, QINF_lx);
 	return noise;
   }
-  if (exp < -QUAD_EXP_MIN) { /*subnormal*/
-	// test for minus infinity
-	if (exp < -(QUAD_EXP_MIN+QUAD_PMAN_SIZE)) {
-		SET_FLT128_WORDS64(noise, QMINF_hx, QMINF_lx);
-		return noise;
-	}
-	//noise will be a subnormal
-	//build HX with sign of d_rand, exp
-	uint64_t u_hx=((uint64_t)(-QUAD_EXP_MIN + QUAD_EXP_COMP)) << QUAD_HX_PMAN_SIZE;
-	//add the sign bit 
-	uint64_t sign= u_rand&DOUBLE_GET_SIGN;
-	u_hx=u_hx+sign;
-	//erase the sign bit from u_rand
-	u_rand=u_rand-sign;
-
-	if (-exp-QUAD_EXP_MIN<-QUAD_HX_PMAN_SIZE){
-		//the higher part of the noise start in HX of noise
-		//set the mantissa part: U_rand>> by -exp-QUAD_EXP_MIN
-		u_hx+=u_rand>>(-exp-QUAD_EXP_MIN+QUAD_EXP_SIZE+1/*SIGN_SIZE*/);
-		//build LX with the remaining bits of the noise (-exp-QUAD_EXP_MIN-QUAD_HX_PMAN_SIZE) at the msb of LX
-		//remove the bit already used in hx and put the remaining at msb of LX
-		uint64_t u_lx=u_rand<<(QUAD_HX_PMAN_SIZE+exp+QUAD_EXP_MIN);	
-        	SET_FLT128_WORDS64(noise, u_hx,u_lx );
-	}else{ //the higher part of the noise start  in LX of noise
-		//the noise as been already implicitly shifeted by QUAD_HX_PMAN_SIZE when starting in LX
-		uint64_t u_lx=u_rand>>(-exp-QUAD_EXP_MIN-QUAD_HX_PMAN_SIZE);
-		SET_FLT128_WORDS64(noise, u_hx, u_lx);
-	}
-	int prec = 20;
-        int width = 46;
-	//char buf[128];
-	//int len=quadmath_snprintf (buf, sizeof(buf), "%+-#*.20Qe", width, noise);
-	//if ((size_t) len < sizeof(buf))
-        //printf ("subnormal noise %s\n", buf);
+  // test for minus infinity
+  if (exp < -(QUAD_EXP_MIN+QUAD_PMAN_SIZE)) {
+	SET_FLT128_WORDS64(noise, QMINF_hx, QMINF_lx);
 	return noise;
   }
-  //normal case
-  //complement the exponent, shift it at the right place in the MSW
-  hx=( ((uint64_t) exp+rexpd(d_rand)) + QUAD_EXP_COMP) << QUAD_HX_PMAN_SIZE;
+  //noise will be a subnormal
+  //build HX with sign of d_rand, exp
+  uint64_t u_hx=((uint64_t)(-QUAD_EXP_MIN + QUAD_EXP_COMP)) << QUAD_HX_PMAN_SIZE;
+  //add the sign bit
+  uint64_t sign= u_rand&DOUBLE_GET_SIGN;
+  u_hx=u_hx+sign;
+  //erase the sign bit from u_rand
+  u_rand=u_rand-sign;
+
+  if (-exp-QUAD_EXP_MIN<-QUAD_HX_PMAN_SIZE){
+	//the higher part of the noise start in HX of noise
+	//set the mantissa part: U_rand>> by -exp-QUAD_EXP_MIN
+	u_hx+=u_rand>>(-exp-QUAD_EXP_MIN+QUAD_EXP_SIZE+1/*SIGN_SIZE*/);
+	//build LX with the remaining bits of the noise (-exp-QUAD_EXP_MIN-QUAD_HX_PMAN_SIZE) at the msb of LX
+	//remove the bit already used in hx and put the remaining at msb of LX
+	uint64_t u_lx=u_rand<<(QUAD_HX_PMAN_SIZE+exp+QUAD_EXP_MIN);
+	SET_FLT128_WORDS64(noise, u_hx,u_lx );
+  }else{ //the higher part of the noise start  in LX of noise
+	//the noise as been already implicitly shifeted by QUAD_HX_PMAN_SIZE when starting in LX
+	uint64_t u_lx=u_rand>>(-exp-QUAD_EXP_MIN-QUAD_HX_PMAN_SIZE);
+	SET_FLT128_WORDS64(noise, u_hx, u_lx);
+  }
+  return noise;
+}
+
+__float128 qnoise(int exp){
+  double d_rand = (_mca_rand() - 0.5);
+  uint64_t u_rand= *((uint64_t*) &d_rand);
+  __float128 noise;
+  uint64_t hx, lx;
+
+  if (__builtin_expect(exp == 0 || exp > QUAD_EXP_MAX || exp < -QUAD_EXP_MIN, 0))
+	return qnoise_special(exp, u_rand);
+
+  //normal case: noise = d_rand * 2^exp, exact in quad precision
+  //the exponent and mantissa fields of d_rand are moved together to
+  //their place in the MSW (52 bits of mantissa = 48 in hx + 4 in lx)...
+  hx=(u_rand&DOUBLE_ERASE_SIGN)>>(DOUBLE_PMAN_SIZE-QUAD_HX_PMAN_SIZE);
+  //...then the exponent is rebiased and scaled by 2^exp in a single add
+  hx+=((uint64_t) (exp+QUAD_EXP_COMP-DOUBLE_EXP_COMP)) << QUAD_HX_PMAN_SIZE;
   //set sign = sign of d_rand
   hx+=u_rand&DOUBLE_GET_SIGN;
-  //extract u_rand (pseudo) mantissa and put the first 48 bits in hx...
-  uint64_t p_mantissa=u_rand&DOUBLE_GET_PMAN;
-  hx+=(p_mantissa)>>(DOUBLE_PMAN_SIZE-QUAD_HX_PMAN_SIZE);//4=52 (double pmantissa) - 48
-  //...and the last 4 in lx at msb
-  //uint64_t 
-  lx=(p_mantissa)<<(SIGN_SIZE+DOUBLE_EXP_SIZE+QUAD_HX_PMAN_SIZE);//60=1(s)+11(exp double)+48(hx)
+  //the last 4 bits of the mantissa go in lx at msb
+  lx=u_rand<<(SIGN_SIZE+DOUBLE_EXP_SIZE+QUAD_HX_PMAN_SIZE);//60=1(s)+11(exp double)+48(hx)
   SET_FLT128_WORDS64(noise, hx, lx);
-  int prec = 20;
-        int width = 46;
-   return noise;
+  return noise;
 }
 
-static int _mca_inexactq(__float128 *qa) {
+static void _mca_inexactq(__float128 *qa, int t) {
 
-	if (MCALIB_OP_TYPE == MCAMODE_IEEE) {
-		return 0;
+	/* zeros are not perturbed, as in the MPFR backend: a noise below the
+	 * double range would give 1/0 a random sign */
+	if (*qa == 0) {
+		return;
 	}
 
-	//if (qa == 0) {
-	//	return 0;
-	//}
-
 	int32_t e_a=0;
 	e_a=rexpq(*qa);
-	int32_t e_n = e_a - MCALIB_T;
+	int32_t e_n = e_a - t;
 	__float128 noise = qnoise(e_n);
 	*qa=noise+*qa;
 }
 
-static int _mca_inexactd(double *da) {
+// pow2v computes pow2d(exp) with masks instead of branches, so that it
+// vectorizes: below the normal range 2^exp is scaled from a normal power
+// of two and rounds to zero under 2^-1074, as the subnormal shift of
+// pow2d does
+static inline __attribute__((always_inline)) double pow2v(int64_t exp) {
+  union {
+    uint64_t u;
+    double d;
+  } x, scale;
+  //all ones below the normal range, where 2^exp = 2^(exp+54) * 2^-54
+  int64_t sub = -(int64_t)(exp < -DOUBLE_EXP_MIN);
+  int64_t e = exp + (sub & 54);
+  e = e < -DOUBLE_EXP_MIN ? -DOUBLE_EXP_MIN : e;
+
+  x.u = ((uint64_t) (e + DOUBLE_EXP_COMP)) << DOUBLE_PMAN_SIZE;
+  scale.u = ((uint64_t) (DOUBLE_EXP_COMP - (sub & 54))) << DOUBLE_PMAN_SIZE;
+  x.d = x.d * scale.d;
+
+  //exceed max exponent
+  uint64_t inf = -(uint64_t)(exp > DOUBLE_EXP_MAX);
+  x.u = (x.u & ~inf) | (DOUBLE_PLUS_INF & inf);
+  return x.d;
+}
+
+// rexpv: rexpd on a value instead of a pointer cast
+static inline __attribute__((always_inline)) int64_t rexpv(double x) {
+  union {
+    uint64_t u;
+    double d;
+  } conv;
+  conv.d = x;
+  return (int64_t) ((conv.u & DOUBLE_ERASE_SIGN) >> DOUBLE_PMAN_SIZE) - DOUBLE_EXP_COMP;
+}
+
+static void _mca_inexactd(double *da, int t) {
 
-	if (MCALIB_OP_TYPE == MCAMODE_IEEE) {
-		return 0;
-	}
 	int32_t e_a=0;
 	e_a=rexpd(*da);
-	int32_t e_n = e_a - MCALIB_T;
+	int32_t e_n = e_a - t;
 	double d_rand = (_mca_rand() - 0.5);
+
+	/* zeros are not perturbed, as in _mca_inexactq. The random number is
+	 * drawn anyway, _mca_svec draws one per operand */
+	if (*da == 0) {
+		return;
+	}
 	*da = *da + pow2d(e_n)*d_rand;
 }
 
-static void _mca_seed(void) {
-	const int key_length = 3;
-	uint64_t init_key[key_length];
-	struct timeval t1;
-	gettimeofday(&t1, NULL);
-
-	/* Hopefully the following seed is good enough for Montercarlo */
-	init_key[0] = t1.tv_sec;
-	init_key[1] = t1.tv_usec;
-	init_key[2] = getpid();
-
-	tinymt64_init_by_array(&random_state, init_key, key_length);
+static void _mca_seed(const struct vfc_rng_config_t *config) {
+	/* Each thread derives its own stream from the configuration */
+	vfc_rng_seed(config, MCABACKEND_QUAD);
 }
 
 /******************** MCA ARITHMETIC FUNCTIONS ********************
 * The following set of functions perform the MCA operation. Operands
 * are first converted to quad  format (GCC), inbound and outbound
 * perturbations are applied using the _mca_inexact function, and the
-* result converted to the original format for return
+* result converted to the original format for return.
+* The mode and the operator are compile time constants: each kernel
+* below is specialized for one of them and has no branch on either.
 *******************************************************************/
 
 // perform_bin_op: applies the binary operator (op) to (a) and (b)
@@ -276,40 +330,115 @@ static void _mca_seed(void) {
     default: perror("invalid operator in mcaquad.\n"); abort();     \
 	};
 
-static inline float _mca_sbin(float a, float b,const int  dop) {
+// inbound and outbound perturbations of each mode
+#define MCA_INBOUND(mode)  ((mode) == MCAMODE_MCA || (mode) == MCAMODE_PB)
+#define MCA_OUTBOUND(mode) ((mode) == MCAMODE_MCA || (mode) == MCAMODE_RR)
+
+// MCA_PRECISION: the virtual precision of the mode, read once by each
+// operation
+#define MCA_PRECISION(mode)                                                \
+	((mode) == MCAMODE_IEEE ? 0 : __atomic_load_n(&MCALIB_T[mode], __ATOMIC_RELAXED))
+
+static inline __attribute__((always_inline))
+float _mca_sbin(float a, float b, const int mode, const int dop) {
 	double da = (double)a;
 	double db = (double)b;
 
 	double res = 0;
+	const int t = MCA_PRECISION(mode);
 
-	if (MCALIB_OP_TYPE != MCAMODE_RR) {
-		_mca_inexactd(&da);
-		_mca_inexactd(&db);
+	if (MCA_INBOUND(mode)) {
+		_mca_inexactd(&da, t);
+		_mca_inexactd(&db, t);
 	}
 
     perform_bin_op(dop, res, da, db);
 
-	if (MCALIB_OP_TYPE != MCAMODE_PB) {
-		_mca_inexactd(&res);
+	if (MCA_OUTBOUND(mode)) {
+		_mca_inexactd(&res, t);
 	}
 
 	return ((float)res);
 }
 
-static inline double _mca_dbin(double a, double b, const int qop) {
+// _mca_svec: n float operations of _mca_sbin. The random numbers are
+// drawn first, in the order of the scalar kernel (inbound a, inbound b,
+// outbound result for each lane), then MCA_VECTOR_LANES lanes are
+// computed by a loop without branches that the compiler vectorizes; the
+// unused lanes get a zero noise. The results are the ones n calls to
+// _mca_sbin would give, provided the noise products are not contracted
+// with the sums into FMAs (see -ffp-contract=off in Makefile.am).
+static inline __attribute__((always_inline))
+void _mca_svec(int n, float *c, const float *a, const float *b,
+               const int mode, const int dop) {
+	const int draws = 2 * MCA_INBOUND(mode) + MCA_OUTBOUND(mode);
+	const int64_t t = MCA_PRECISION(mode);
+	double rand[3 * MCA_VECTOR_LANES];
+	double ra[MCA_VECTOR_LANES], rb[MCA_VECTOR_LANES], rr[MCA_VECTOR_LANES];
+	float fa[MCA_VECTOR_LANES], fb[MCA_VECTOR_LANES], fc[MCA_VECTOR_LANES];
+	int i, j;
+
+	if (n < MCA_VECTOR_MIN) {
+		for (i = 0; i < n; i++)
+			c[i] = _mca_sbin(a[i], b[i], mode, dop);
+		return;
+	}
+
+	for (i = 0; i < n; i += MCA_VECTOR_LANES) {
+		int lanes = n - i < MCA_VECTOR_LANES ? n - i : MCA_VECTOR_LANES;
+
+		if (draws > 0)
+			vfc_rng_doubleOO_array(rand, draws * lanes);
+		for (j = 0; j < MCA_VECTOR_LANES; j++) {
+			int used = j < lanes;
+			fa[j] = used ? a[i + j] : 1;
+			fb[j] = used ? b[i + j] : 1;
+			ra[j] = MCA_INBOUND(mode) && used ? rand[draws * j] : 0.5;
+			rb[j] = MCA_INBOUND(mode) && used ? rand[draws * j + 1] : 0.5;
+			rr[j] = MCA_OUTBOUND(mode) && used ? rand[draws * j + draws - 1] : 0.5;
+		}
+
+		for (j = 0; j < MCA_VECTOR_LANES; j++) {
+			double da = (double)fa[j];
+			double db = (double)fb[j];
+			double res = 0;
+
+			/* zeros are not perturbed */
+			if (MCA_INBOUND(mode)) {
+				da = da + (da != 0 ? pow2v(rexpv(da) - t) * (ra[j] - 0.5) : 0);
+				db = db + (db != 0 ? pow2v(rexpv(db) - t) * (rb[j] - 0.5) : 0);
+			}
+
+			perform_bin_op(dop, res, da, db);
+
+			if (MCA_OUTBOUND(mode)) {
+				res = res + (res != 0 ? pow2v(rexpv(res) - t) * (rr[j] - 0.5) : 0);
+			}
+
+			fc[j] = (float)res;
+		}
+
+		for (j = 0; j < lanes; j++)
+			c[i + j] = fc[j];
+	}
+}
+
+static inline __attribute__((always_inline))
+double _mca_dbin(double a, double b, const int mode, const int qop) {
 	__float128 qa = (__float128)a;
 	__float128 qb = (__float128)b;
 	__float128 res = 0;
+	const int t = MCA_PRECISION(mode);
 
-	if (MCALIB_OP_TYPE != MCAMODE_RR) {
-		_mca_inexactq(&qa);
-		_mca_inexactq(&qb);
+	if (MCA_INBOUND(mode)) {
+		_mca_inexactq(&qa, t);
+		_mca_inexactq(&qb, t);
 	}
 
     perform_bin_op(qop, res, qa, qb);
 
-	if (MCALIB_OP_TYPE != MCAMODE_PB) {
-		_mca_inexactq(&res);
+	if (MCA_OUTBOUND(mode)) {
+		_mca_inexactq(&res, t);
 	}
 
 	return NEAREST_DOUBLE(res);
@@ -319,60 +448,90 @@ static inline double _mca_dbin(double a, double b, const int qop) {
 /************************* FPHOOKS FUNCTIONS *************************
 * These functions correspond to those inserted into the source code
 * during source to source compilation and are replacement to floating
-* point operators
+* point operators. MCA_KERNELS defines them for one mode.
 **********************************************************************/
 
-static float _floatadd(float a, float b) {
-	return _mca_sbin(a, b, MCA_ADD);
-}
-
-static float _floatsub(float a, float b) {
-	//return a - b
-	return _mca_sbin(a, b, MCA_SUB);
+#define MCA_KERNELS(MODE)                                               \
+static float _floatadd_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static float _floatsub_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+static float _floatmul_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+static float _floatdiv_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}                                                                       \
+static double _doubleadd_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static double _doublesub_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+static double _doublemul_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+static double _doublediv_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}                                                                       \
+QUAD_TARGET_CLONES                                                      \
+static void _floatadd_vector_##MODE(int n, float *c,                    \
+                                    const float *a, const float *b) {   \
+	_mca_svec(n, c, a, b, MCAMODE_##MODE, MCA_ADD);                 \
+}                                                                       \
+QUAD_TARGET_CLONES                                                      \
+static void _floatsub_vector_##MODE(int n, float *c,                    \
+                                    const float *a, const float *b) {   \
+	_mca_svec(n, c, a, b, MCAMODE_##MODE, MCA_SUB);                 \
+}                                                                       \
+QUAD_TARGET_CLONES                                                      \
+static void _floatmul_vector_##MODE(int n, float *c,                    \
+                                    const float *a, const float *b) {   \
+	_mca_svec(n, c, a, b, MCAMODE_##MODE, MCA_MUL);                 \
+}                                                                       \
+QUAD_TARGET_CLONES                                                      \
+static void _floatdiv_vector_##MODE(int n, float *c,                    \
+                                    const float *a, const float *b) {   \
+	_mca_svec(n, c, a, b, MCAMODE_##MODE, MCA_DIV);                 \
 }
 
-static float _floatmul(float a, float b) {
-	//return a * b
-	return _mca_sbin(a, b, MCA_MUL);
+MCA_KERNELS(IEEE)
+MCA_KERNELS(MCA)
+MCA_KERNELS(PB)
+MCA_KERNELS(RR)
+
+#define MCA_INTERFACE(MODE) {                                           \
+	_floatadd_##MODE,                                               \
+	_floatsub_##MODE,                                               \
+	_floatmul_##MODE,                                               \
+	_floatdiv_##MODE,                                               \
+	_doubleadd_##MODE,                                              \
+	_doublesub_##MODE,                                              \
+	_doublemul_##MODE,                                              \
+	_doublediv_##MODE,                                              \
+	_mca_seed,                                                      \
+	_set_mca_mode,                                                  \
+	_set_mca_precision,                                             \
+	_floatadd_vector_##MODE,                                        \
+	_floatsub_vector_##MODE,                                        \
+	_floatmul_vector_##MODE,                                        \
+	_floatdiv_vector_##MODE                                         \
 }
 
-static float _floatdiv(float a, float b) {
-	//return a / b
-	return _mca_sbin(a, b, MCA_DIV);
-}
-
-
-static double _doubleadd(double a, double b) {
-	double tmp=_mca_dbin(a,b,MCA_ADD);  
-	return tmp;
-}
-
-static double _doublesub(double a, double b) {
-	//return a - b
-	return _mca_dbin(a, b, MCA_SUB);
-}
+/* vtables indexed by mode */
+static const struct mca_interface_t _mca_kernels[] = {
+	[MCAMODE_IEEE] = MCA_INTERFACE(IEEE),
+	[MCAMODE_MCA]  = MCA_INTERFACE(MCA),
+	[MCAMODE_PB]   = MCA_INTERFACE(PB),
+	[MCAMODE_RR]   = MCA_INTERFACE(RR),
+};
 
-static double _doublemul(double a, double b) {
-	//return a * b
-	return _mca_dbin(a, b, MCA_MUL);
-}
+struct mca_interface_t quad_mca_interface = MCA_INTERFACE(IEEE);
 
-static double _doublediv(double a, double b) {
-	//return a / b
-	return _mca_dbin(a, b, MCA_DIV);
+/* The wrapper copies quad_mca_interface after setting the mode,
+ * so the instrumented code calls the kernels of that mode */
+static void _mca_select_kernels(int mode) {
+	quad_mca_interface = _mca_kernels[mode];
 }
-
-
-struct mca_interface_t quad_mca_interface = {
-	_floatadd,
-	_floatsub,
-	_floatmul,
-	_floatdiv,
-	_doubleadd,
-	_doublesub,
-	_doublemul,
-	_doublediv,
-	_mca_seed,
-	_set_mca_mode,
-	_set_mca_precision
-};
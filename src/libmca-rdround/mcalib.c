@@ -0,0 +1,269 @@
+/********************************************************************************
+ *                                                                              *
+ *  This file is part of Verificarlo.                                           *
+ *                                                                              *
+ *  Copyright (c) 2026                                                          *
+ *     Universite de Versailles St-Quentin-en-Yvelines                          *
+ *     CMLA, Ecole Normale Superieure de Cachan                                 *
+ *                                                                              *
+ *  Verificarlo is free software: you can redistribute it and/or modify         *
+ *  it under the terms of the GNU General Public License as published by        *
+ *  the Free Software Foundation, either version 3 of the License, or           *
+ *  (at your option) any later version.                                         *
+ *                                                                              *
+ *  Verificarlo is distributed in the hope that it will be useful,              *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ *  GNU General Public License for more details.                                *
+ *                                                                              *
+ *  You should have received a copy of the GNU General Public License           *
+ *  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+ *                                                                              *
+ ********************************************************************************/
+
+
+// Changelog:
+//
+// 2026-10-19 Random rounding backend
+//
+// Each operation is computed in its native precision together with its
+// exact rounding error, see vfc_eft.h. The result is then rounded up or
+// down with a probability proportional to the distance of the exact
+// result to the other neighbouring floating point number: an exact
+// operation is never perturbed and the rounding is unbiased.
+//
+// Random rounding is applied in MCA and RR modes, IEEE and PB modes
+// compute the native operations. The virtual precision is ignored:
+// results are rounded at the precision of their type.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "libmca-rdround.h"
+#include "../vfcwrapper/vfcwrapper.h"
+#include "../common/vfc_eft.h"
+#include "../common/vfc_rng.h"
+
+//possible op values
+#define MCA_ADD 1
+#define MCA_SUB 2
+#define MCA_MUL 3
+#define MCA_DIV 4
+
+static void _mca_select_kernels(int mode);
+
+/******************** MCA CONTROL FUNCTIONS *******************
+* The following functions are used to set virtual precision and
+* MCA mode of operation.
+***************************************************************/
+
+static int _set_mca_mode(int mode){
+	if (mode < 0 || mode > 3)
+		return -1;
+
+	_mca_select_kernels(mode);
+	return 0;
+}
+
+static int _set_mca_precision(int precision){
+	/* ignored, results are rounded at their native precision */
+	(void)precision;
+	return 0;
+}
+
+/******************** MCA RANDOM FUNCTIONS ********************
+* The following functions are used to calculate the random
+* roundings
+***************************************************************/
+
+static double _mca_rand(void) {
+	/* Returns a random double in the (0,1) open interval */
+	return vfc_rng_doubleOO();
+}
+
+static void _mca_seed(const struct vfc_rng_config_t *config) {
+	/* Each thread derives its own stream from the configuration */
+	vfc_rng_seed(config, MCABACKEND_RDROUND);
+}
+
+/* Rounds the exact result x + err, where x is the nearest double, to
+ * the neighbour of x in the direction of err with probability
+ * |err| / |neighbour - x|, and to x otherwise */
+static inline double dround(double x, double err) {
+	if (err == 0 || !isfinite(x))
+		return x;
+
+	double next = dnext(x, err);
+	if (_mca_rand() * fabs(next - x) < fabs(err))
+		return next;
+	return x;
+}
+
+static inline float fround(float x, double err) {
+	if (err == 0 || !isfinite(x))
+		return x;
+
+	float next = fnext(x, err);
+	if (_mca_rand() * fabs((double) next - x) < fabs(err))
+		return next;
+	return x;
+}
+
+/******************** MCA ARITHMETIC FUNCTIONS ********************
+* The following set of functions perform the randomly rounded
+* operations. The result rounded to the nearest and its exact error
+* are computed with error-free transformations, then passed to
+* dround or fround.
+* The mode and the operator are compile time constants: each kernel
+* below is specialized for one of them and has no branch on either.
+*******************************************************************/
+
+// perform_bin_op: applies the binary operator (op) to (a) and (b)
+// and stores the result in (res)
+#define perform_bin_op(op, res, a, b)                               \
+    switch (op){                                                    \
+    case MCA_ADD: res=(a)+(b); break;                               \
+    case MCA_MUL: res=(a)*(b); break;                               \
+    case MCA_SUB: res=(a)-(b); break;                               \
+    case MCA_DIV: res=(a)/(b); break;                               \
+    default: perror("invalid operator in mcardround.\n"); abort();  \
+	};
+
+// the results are randomly rounded in the modes with outbound errors
+#define MCA_OUTBOUND(mode) ((mode) == MCAMODE_MCA || (mode) == MCAMODE_RR)
+
+static inline __attribute__((always_inline))
+float _mca_sbin(float a, float b, const int mode, const int op) {
+	float res = 0;
+	double err = 0;
+
+	if (!MCA_OUTBOUND(mode)) {
+		perform_bin_op(op, res, a, b);
+		return res;
+	}
+
+	switch (op){
+	case MCA_SUB:
+		b = -b;
+		/* fall through */
+	case MCA_ADD:
+		res = a + b;
+		err = fadd_error(a, b, res);
+		break;
+	case MCA_MUL:
+		res = a * b;
+		err = fmul_error(a, b, res);
+		break;
+	case MCA_DIV:
+		res = a / b;
+		err = fdiv_error(a, b, res);
+		break;
+	default: perror("invalid operator in mcardround.\n"); abort();
+	};
+
+	return fround(res, err);
+}
+
+static inline __attribute__((always_inline))
+double _mca_dbin(double a, double b, const int mode, const int op) {
+	double res = 0;
+	double err = 0;
+
+	if (!MCA_OUTBOUND(mode)) {
+		perform_bin_op(op, res, a, b);
+		return res;
+	}
+
+	switch (op){
+	case MCA_SUB:
+		b = -b;
+		/* fall through */
+	case MCA_ADD:
+		res = a + b;
+		err = dadd_error(a, b, res);
+		break;
+	case MCA_MUL:
+		res = a * b;
+		err = dmul_error(a, b, res);
+		break;
+	case MCA_DIV:
+		res = a / b;
+		err = ddiv_error(a, b, res);
+		break;
+	default: perror("invalid operator in mcardround.\n"); abort();
+	};
+
+	return dround(res, err);
+}
+
+/************************* FPHOOKS FUNCTIONS *************************
+* These functions correspond to those inserted into the source code
+* during source to source compilation and are replacement to floating
+* point operators. MCA_KERNELS defines them for one mode.
+**********************************************************************/
+
+#define MCA_KERNELS(MODE)                                               \
+static float _floatadd_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static float _floatsub_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+static float _floatmul_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+static float _floatdiv_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}                                                                       \
+static double _doubleadd_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static double _doublesub_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+VFC_FMA_TARGET_CLONES                                                   \
+static double _doublemul_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+VFC_FMA_TARGET_CLONES                                                   \
+static double _doublediv_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}
+
+MCA_KERNELS(IEEE)
+MCA_KERNELS(MCA)
+MCA_KERNELS(PB)
+MCA_KERNELS(RR)
+
+#define MCA_INTERFACE(MODE) {                                           \
+	_floatadd_##MODE,                                               \
+	_floatsub_##MODE,                                               \
+	_floatmul_##MODE,                                               \
+	_floatdiv_##MODE,                                               \
+	_doubleadd_##MODE,                                              \
+	_doublesub_##MODE,                                              \
+	_doublemul_##MODE,                                              \
+	_doublediv_##MODE,                                              \
+	_mca_seed,                                                      \
+	_set_mca_mode,                                                  \
+	_set_mca_precision                                              \
+}
+
+/* vtables indexed by mode */
+static const struct mca_interface_t _mca_kernels[] = {
+	[MCAMODE_IEEE] = MCA_INTERFACE(IEEE),
+	[MCAMODE_MCA]  = MCA_INTERFACE(MCA),
+	[MCAMODE_PB]   = MCA_INTERFACE(PB),
+	[MCAMODE_RR]   = MCA_INTERFACE(RR),
+};
+
+struct mca_interface_t rdround_mca_interface = MCA_INTERFACE(IEEE);
+
+/* The wrapper copies rdround_mca_interface after setting the mode,
+ * so the instrumented code calls the kernels of that mode */
+static void _mca_select_kernels(int mode) {
+	rdround_mca_interface = _mca_kernels[mode];
+}
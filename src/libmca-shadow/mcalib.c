@@ -0,0 +1,509 @@
+/********************************************************************************
+ *                                                                              *
+ *  This file is part of Verificarlo.                                           *
+ *                                                                              *
+ *  Copyright (c) 2026                                                          *
+ *     Universite de Versailles St-Quentin-en-Yvelines                          *
+ *     CMLA, Ecole Normale Superieure de Cachan                                 *
+ *                                                                              *
+ *  Verificarlo is free software: you can redistribute it and/or modify         *
+ *  it under the terms of the GNU General Public License as published by        *
+ *  the Free Software Foundation, either version 3 of the License, or           *
+ *  (at your option) any later version.                                         *
+ *                                                                              *
+ *  Verificarlo is distributed in the hope that it will be useful,              *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ *  GNU General Public License for more details.                                *
+ *                                                                              *
+ *  You should have received a copy of the GNU General Public License           *
+ *  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+ *                                                                              *
+ ********************************************************************************/
+
+
+
+// Changelog:
+//
+// 2026-10-19 Shadow value backend
+//
+// The program computes the native operations, while each result is also
+// computed in higher precision from the higher precision values of its
+// operands, in double for floats and in double-double (vfc_eft.h) for
+// doubles. The local error of an operation is the relative error of the
+// native operation applied to its operands rounded from their shadows,
+// measured against the shadow result: it is the error the operation
+// introduces, independently of the errors it inherits from its operands.
+// Each instrumented call site keeps the number of operations it computed
+// and the largest local error it introduced, and the sites are ranked at
+// exit: a single run shows where the accuracy is lost.
+//
+// The instrumented code calls the backend with values, not addresses. As
+// in the CESTAC backend the shadows of the results computed by a thread
+// are kept in a direct mapped cache indexed by the bits of the native
+// result, and a value absent from the cache is its own shadow. An
+// unrelated value equal to a cached result, typically a constant, takes
+// the shadow of that result, and its operations may then report a false
+// local error: see the SHADOW backend in README.md.
+//
+// The call site of an operation is the return address of its kernel,
+// which the instrumentation calls without tail calls, or the site
+// recorded by the vector wrapper or hook calling the kernel.
+//
+// The results are the native ones in every mode: the MCA mode and the
+// virtual precision are accepted and ignored.
+//
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <elf.h>
+#include <float.h>
+#include <link.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "libmca-shadow.h"
+#include "../vfcwrapper/vfcwrapper.h"
+#include "../common/vfc_eft.h"
+
+#define VERIFICARLO_SHADOW_REPORT "VERIFICARLO_SHADOW_REPORT"
+
+//possible op values
+#define MCA_ADD 1
+#define MCA_SUB 2
+#define MCA_MUL 3
+#define MCA_DIV 4
+
+// each thread caches the shadows of the last 2^SHADOW_CACHE_BITS results
+// of each type
+#define SHADOW_CACHE_BITS 16
+#define SHADOW_CACHE_SIZE (1 << SHADOW_CACHE_BITS)
+
+// call sites recorded, a power of two
+#define SHADOW_SITES_BITS 16
+#define SHADOW_SITES_SIZE (1 << SHADOW_SITES_BITS)
+
+/******************** MCA CONTROL FUNCTIONS *******************
+* The following functions are used to set virtual precision and
+* MCA mode of operation.
+***************************************************************/
+
+/* call site recorded by the runtime, see SHADOW_SITE */
+static uintptr_t (*_shadow_caller)(void) = NULL;
+
+static int _set_mca_mode(int mode){
+	/* every mode is accepted and ignored, the results are native */
+	if (mode < 0 || mode > 3)
+		return -1;
+	return 0;
+}
+
+static int _set_mca_precision(int precision){
+	/* ignored, results are computed at their native precision */
+	(void)precision;
+	return 0;
+}
+
+static void _mca_seed(const struct vfc_rng_config_t *config) {
+	/* no random numbers are drawn */
+	_shadow_caller = config->caller;
+}
+
+/******************** SHADOW CACHE ****************************
+* The shadows of the results computed by a thread, in two direct
+* mapped tables indexed by a hash of the native result bits. The
+* cache of a thread is allocated on its first operation and only
+* its address is thread local, as in the CESTAC backend.
+***************************************************************/
+
+struct shadow_dentry {
+	uint64_t key;                   /* bits of the native result */
+	dd_t x;
+};
+
+struct shadow_fentry {
+	uint32_t key;                   /* bits of the native result */
+	double x;
+};
+
+struct shadow_cache_t {
+	struct shadow_dentry d[SHADOW_CACHE_SIZE];
+	struct shadow_fentry f[SHADOW_CACHE_SIZE];
+};
+
+static pthread_key_t _shadow_free_key;
+static pthread_once_t _shadow_once = PTHREAD_ONCE_INIT;
+static __thread struct shadow_cache_t * _shadow_local
+	__attribute__((tls_model("initial-exec")));
+
+/* releases the cache of an exiting thread */
+static void _shadow_free(void * cache) {
+	_shadow_local = NULL;
+	free(cache);
+}
+
+static void _shadow_init_once(void) {
+	pthread_key_create(&_shadow_free_key, _shadow_free);
+}
+
+/* Allocates a cache where every entry holds the exact value zero */
+static struct shadow_cache_t * __attribute__((noinline)) _shadow_cache_new(void) {
+	struct shadow_cache_t * cache = calloc(1, sizeof(struct shadow_cache_t));
+	if (cache == NULL) {
+		perror("mcashadow: cannot allocate the thread shadow cache");
+		abort();
+	}
+	pthread_once(&_shadow_once, _shadow_init_once);
+	pthread_setspecific(_shadow_free_key, cache);
+	_shadow_local = cache;
+	return cache;
+}
+
+/* Returns the cache of the calling thread */
+static inline struct shadow_cache_t * _shadow_cache(void) {
+	struct shadow_cache_t * cache = _shadow_local;
+	if (__builtin_expect(cache != NULL, 1))
+		return cache;
+	return _shadow_cache_new();
+}
+
+static inline uint32_t _shadow_hash(uint64_t key) {
+	return (uint32_t) ((key * UINT64_C(0x9e3779b97f4a7c15)) >> (64 - SHADOW_CACHE_BITS));
+}
+
+/* Returns the shadow of a. The shadow of -a is the opposite of the
+ * shadow of a: negations are not instrumented. */
+static inline dd_t _shadow_dload(const struct shadow_cache_t * cache, double a) {
+	union {
+		uint64_t u;
+		double d;
+	} hex = { .d = a };
+	dd_t x = { a, 0 };
+
+	const struct shadow_dentry * e = &cache->d[_shadow_hash(hex.u)];
+	if (__builtin_expect(e->key == hex.u, 1))
+		return e->x;
+	hex.u ^= UINT64_C(1) << 63;
+	e = &cache->d[_shadow_hash(hex.u)];
+	return e->key == hex.u ? dd_neg(e->x) : x;
+}
+
+static inline double _shadow_fload(const struct shadow_cache_t * cache, float a) {
+	union {
+		uint32_t u;
+		float f;
+	} hex = { .f = a };
+
+	const struct shadow_fentry * e = &cache->f[_shadow_hash(hex.u)];
+	if (__builtin_expect(e->key == hex.u, 1))
+		return e->x;
+	hex.u ^= UINT32_C(1) << 31;
+	e = &cache->f[_shadow_hash(hex.u)];
+	return e->key == hex.u ? -e->x : a;
+}
+
+static inline void _shadow_dstore(struct shadow_cache_t * cache, double a, dd_t x) {
+	union {
+		uint64_t u;
+		double d;
+	} hex = { .d = a };
+
+	struct shadow_dentry * e = &cache->d[_shadow_hash(hex.u)];
+	e->key = hex.u;
+	e->x = x;
+}
+
+static inline void _shadow_fstore(struct shadow_cache_t * cache, float a, double x) {
+	union {
+		uint32_t u;
+		float f;
+	} hex = { .f = a };
+
+	struct shadow_fentry * e = &cache->f[_shadow_hash(hex.u)];
+	e->key = hex.u;
+	e->x = x;
+}
+
+/* Relative error of x against its shadow s, where x - s is exact.
+ * A value whose shadow is not finite has no error. */
+static inline double _shadow_error(double diff, double s) {
+	if (!isfinite(s) || diff == 0)
+		return 0;
+	if (s == 0)
+		return INFINITY;
+	return fabs(diff / s);
+}
+
+/******************** SIGNIFICANT DIGITS **********************
+* The number of decimal digits of a value in agreement with its
+* shadow, clamped between 0 and the digits of the type.
+***************************************************************/
+
+static double _shadow_digits(double error, double max) {
+	if (error == 0)
+		return max;
+	double digits = -log10(error);
+	if (!(digits > 0))
+		return 0;
+	return digits < max ? digits : max;
+}
+
+static double _doubledigits(double a) {
+	dd_t s = _shadow_dload(_shadow_cache(), a);
+	dd_t d = dd_add(two_sum(a, 0), dd_neg(s));
+	return _shadow_digits(_shadow_error(d.hi, s.hi), DBL_MANT_DIG * log10(2));
+}
+
+static double _floatdigits(float a) {
+	double s = _shadow_fload(_shadow_cache(), a);
+	return _shadow_digits(_shadow_error(a - s, s), FLT_MANT_DIG * log10(2));
+}
+
+/******************** CALL SITES ******************************
+* The sites are recorded in a table shared by all the threads,
+* open addressed by a hash of their address, where a site is
+* inserted with a compare and swap. The largest local error of a
+* site only grows: it is updated with a compare and swap on its
+* bits, positive doubles being ordered as their bits.
+***************************************************************/
+
+struct shadow_site {
+	uintptr_t address;              /* call site, 0 if the slot is free */
+	uint64_t count;                 /* operations computed */
+	uint64_t error;                 /* bits of the largest local error */
+};
+
+static struct shadow_site _shadow_sites[SHADOW_SITES_SIZE];
+static int _shadow_sites_full = 0;
+
+/* Returns the entry of a site, NULL if the table is full */
+static struct shadow_site * _shadow_site(uintptr_t address) {
+	uint32_t h = _shadow_hash(address) & (SHADOW_SITES_SIZE - 1);
+	uint32_t i;
+
+	for (i = 0; i < SHADOW_SITES_SIZE; i++) {
+		struct shadow_site * s = &_shadow_sites[(h + i) & (SHADOW_SITES_SIZE - 1)];
+		uintptr_t a = __atomic_load_n(&s->address, __ATOMIC_ACQUIRE);
+		if (__builtin_expect(a == address, 1))
+			return s;
+		if (a == 0) {
+			uintptr_t expected = 0;
+			if (__atomic_compare_exchange_n(&s->address, &expected, address, 0,
+			                                __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+			    || expected == address)
+				return s;
+		}
+	}
+	_shadow_sites_full = 1;
+	return NULL;
+}
+
+/* Records an operation of a site and the local error it introduced */
+static inline void _shadow_record(void * address, double error) {
+	struct shadow_site * s = _shadow_site((uintptr_t) address);
+	if (s == NULL)
+		return;
+
+	union {
+		uint64_t u;
+		double d;
+	} e = { .d = error };
+	__atomic_add_fetch(&s->count, 1, __ATOMIC_RELAXED);
+	uint64_t old = __atomic_load_n(&s->error, __ATOMIC_RELAXED);
+	while (e.u > old
+	       && !__atomic_compare_exchange_n(&s->error, &old, e.u, 1,
+	                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+		;
+}
+
+static int _shadow_compare(const void * a, const void * b) {
+	const struct shadow_site * x = a, * y = b;
+	if (x->error != y->error)
+		return x->error < y->error ? 1 : -1;
+	if (x->count != y->count)
+		return x->count < y->count ? 1 : -1;
+	return 0;
+}
+
+/* Writes the sites ranked by largest local error, to the file given by
+ * VERIFICARLO_SHADOW_REPORT or to stderr. A site is printed as the
+ * object it belongs to and the address that addr2line expects for it:
+ * its offset in shared objects and position independent executables. */
+static void __attribute__((destructor)) _shadow_report(void) {
+	struct shadow_site * sites = malloc(sizeof(_shadow_sites));
+	int i, n = 0;
+
+	if (sites == NULL)
+		return;
+	for (i = 0; i < SHADOW_SITES_SIZE; i++) {
+		if (_shadow_sites[i].address != 0)
+			sites[n++] = _shadow_sites[i];
+	}
+	if (n == 0) {
+		free(sites);
+		return;
+	}
+	qsort(sites, n, sizeof(struct shadow_site), _shadow_compare);
+
+	char * path = getenv(VERIFICARLO_SHADOW_REPORT);
+	FILE * f = path == NULL ? stderr : fopen(path, "w");
+	if (f == NULL) {
+		fprintf(stderr, "Cannot write shadow report to %s\n", path);
+		free(sites);
+		return;
+	}
+
+	if (_shadow_sites_full)
+		fprintf(f, "# more than %d sites, some are not reported\n", SHADOW_SITES_SIZE);
+	fprintf(f, "# %-10s %-18s %12s %8s  %s\n", "error", "address", "count", "digits", "object");
+	for (i = 0; i < n; i++) {
+		union {
+			uint64_t u;
+			double d;
+		} e = { .u = sites[i].error };
+		uintptr_t address = sites[i].address;
+		const char * object = "?";
+		Dl_info info;
+
+		if (dladdr((void *) address, &info) != 0 && info.dli_fname != NULL) {
+			const ElfW(Ehdr) * header = info.dli_fbase;
+			object = info.dli_fname;
+			if (header != NULL && header->e_type == ET_DYN)
+				address -= (uintptr_t) info.dli_fbase;
+		}
+		fprintf(f, "%-12.3e 0x%-16lx %12llu %8.2f  %s\n", e.d,
+		        (unsigned long) address, (unsigned long long) sites[i].count,
+		        _shadow_digits(e.d, DBL_MANT_DIG * log10(2)), object);
+	}
+	if (f != stderr)
+		fclose(f);
+	free(sites);
+}
+
+/******************** MCA ARITHMETIC FUNCTIONS ********************
+* The following set of functions compute the native result, the
+* shadow result and the local error of an operation. The native
+* operation is also applied to the operands rounded from their
+* shadows: its difference with the shadow result is the error the
+* operation introduces.
+*******************************************************************/
+
+// perform_bin_op: applies the binary operator (op) to (a) and (b)
+// and stores the result in (res)
+#define perform_bin_op(op, res, a, b)                               \
+    switch (op){                                                    \
+    case MCA_ADD: res=(a)+(b); break;                               \
+    case MCA_MUL: res=(a)*(b); break;                               \
+    case MCA_SUB: res=(a)-(b); break;                               \
+    case MCA_DIV: res=(a)/(b); break;                               \
+    default: perror("invalid operator in mcashadow.\n"); abort();   \
+	};
+
+static inline __attribute__((always_inline))
+float _mca_sbin(float a, float b, const int op, void * site) {
+	struct shadow_cache_t * cache = _shadow_cache();
+	float res = 0, local = 0;
+	double x, y, s = 0;
+
+	x = _shadow_fload(cache, a);
+	y = _shadow_fload(cache, b);
+	perform_bin_op(op, res, a, b);
+	perform_bin_op(op, s, x, y);
+	perform_bin_op(op, local, (float)x, (float)y);
+	_shadow_fstore(cache, res, s);
+	_shadow_record(site, _shadow_error(local - s, s));
+	return res;
+}
+
+static inline __attribute__((always_inline))
+double _mca_dbin(double a, double b, const int op, void * site) {
+	struct shadow_cache_t * cache = _shadow_cache();
+	double res = 0, local = 0;
+	dd_t x, y, s;
+
+	x = _shadow_dload(cache, a);
+	y = _shadow_dload(cache, b);
+	perform_bin_op(op, res, a, b);
+	perform_bin_op(op, local, x.hi, y.hi);
+	switch (op){
+	case MCA_ADD: s = dd_add(x, y); break;
+	case MCA_SUB: s = dd_add(x, dd_neg(y)); break;
+	case MCA_MUL: s = dd_mul(x, y); break;
+	case MCA_DIV: s = dd_div(x, y); break;
+	default: perror("invalid operator in mcashadow.\n"); abort();
+	};
+	_shadow_dstore(cache, res, s);
+	/* local - s.hi is exact when they are close, and the error large
+	 * otherwise */
+	_shadow_record(site, _shadow_error((local - s.hi) - s.lo, s.hi));
+	return res;
+}
+
+/************************* FPHOOKS FUNCTIONS *************************
+* These functions correspond to those inserted into the source code
+* during source to source compilation and are replacement to floating
+* point operators. When the instrumented code calls them directly,
+* their return address identifies the call site. A vector wrapper or
+* hook of the runtime calling them records the site of its own caller.
+**********************************************************************/
+
+static inline void * _shadow_call_site(void * ret) {
+	uintptr_t caller = _shadow_caller != NULL ? _shadow_caller() : 0;
+	return caller != 0 ? (void *) caller : (char *) ret - 1;
+}
+
+#define SHADOW_SITE() \
+	_shadow_call_site(__builtin_extract_return_addr(__builtin_return_address(0)))
+
+static float _floatadd(float a, float b) {
+	return _mca_sbin(a, b, MCA_ADD, SHADOW_SITE());
+}
+
+static float _floatsub(float a, float b) {
+	return _mca_sbin(a, b, MCA_SUB, SHADOW_SITE());
+}
+
+static float _floatmul(float a, float b) {
+	return _mca_sbin(a, b, MCA_MUL, SHADOW_SITE());
+}
+
+static float _floatdiv(float a, float b) {
+	return _mca_sbin(a, b, MCA_DIV, SHADOW_SITE());
+}
+
+static double _doubleadd(double a, double b) {
+	return _mca_dbin(a, b, MCA_ADD, SHADOW_SITE());
+}
+
+static double _doublesub(double a, double b) {
+	return _mca_dbin(a, b, MCA_SUB, SHADOW_SITE());
+}
+
+VFC_FMA_TARGET_CLONES
+static double _doublemul(double a, double b) {
+	return _mca_dbin(a, b, MCA_MUL, SHADOW_SITE());
+}
+
+VFC_FMA_TARGET_CLONES
+static double _doublediv(double a, double b) {
+	return _mca_dbin(a, b, MCA_DIV, SHADOW_SITE());
+}
+
+struct mca_interface_t shadow_mca_interface = {
+	.floatadd = _floatadd,
+	.floatsub = _floatsub,
+	.floatmul = _floatmul,
+	.floatdiv = _floatdiv,
+	.doubleadd = _doubleadd,
+	.doublesub = _doublesub,
+	.doublemul = _doublemul,
+	.doublediv = _doublediv,
+	.seed = _mca_seed,
+	.set_mca_mode = _set_mca_mode,
+	.set_mca_precision = _set_mca_precision,
+	.floatdigits = _floatdigits,
+	.doubledigits = _doubledigits
+};
@@ -0,0 +1,307 @@
+/********************************************************************************
+ *                                                                              *
+ *  This file is part of Verificarlo.                                           *
+ *                                                                              *
+ *  Copyright (c) 2026                                                          *
+ *     Universite de Versailles St-Quentin-en-Yvelines                          *
+ *     CMLA, Ecole Normale Superieure de Cachan                                 *
+ *                                                                              *
+ *  Verificarlo is free software: you can redistribute it and/or modify         *
+ *  it under the terms of the GNU General Public License as published by        *
+ *  the Free Software Foundation, either version 3 of the License, or           *
+ *  (at your option) any later version.                                         *
+ *                                                                              *
+ *  Verificarlo is distributed in the hope that it will be useful,              *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the               *
+ *  GNU General Public License for more details.                                *
+ *                                                                              *
+ *  You should have received a copy of the GNU General Public License           *
+ *  along with Verificarlo.  If not, see <http://www.gnu.org/licenses/>.        *
+ *                                                                              *
+ ********************************************************************************/
+
+
+// Changelog:
+//
+// 2026-10-19 Virtual precision backend
+//
+// Each operation is computed in its native precision and the result is
+// rounded to the virtual precision by masking the low bits of its
+// mantissa. The rounding is deterministic (to nearest even, toward zero)
+// or stochastic, as selected by VERIFICARLO_VPREC_ROUNDING.
+//
+// Operands are rounded in MCA and PB modes, results in MCA and RR modes,
+// IEEE mode computes the native operations. Precisions above 24 bits for
+// floats and 53 bits for doubles leave the values unchanged. Subnormal
+// values are rounded at the same absolute position as the smallest
+// normal values, the exponent range is not reduced.
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "libmca-vprec.h"
+#include "../vfcwrapper/vfcwrapper.h"
+#include "../common/vfc_rng.h"
+#include "../common/mca_const.h"
+
+#define VERIFICARLO_VPREC_ROUNDING "VERIFICARLO_VPREC_ROUNDING"
+
+//possible rounding values
+#define VPREC_NEAREST 0
+#define VPREC_ZERO    1
+#define VPREC_RANDOM  2
+
+static const char * _vprec_rounding_names[] = { "NEAREST", "ZERO", "RANDOM" };
+
+//bits of the mantissas dropped by the rounding in each mode, published
+//with the kernels of the mode by _set_mca_mode as in the QUAD backend
+static int 	VPREC_PRECISION_NEXT	    = DOUBLE_PREC;
+static int 	VPREC_FLOAT_DROP[MCAMODE_RR + 1];
+static int 	VPREC_DOUBLE_DROP[MCAMODE_RR + 1];
+static int 	VPREC_ROUNDING		    = VPREC_NEAREST;
+
+//possible op values
+#define MCA_ADD 1
+#define MCA_SUB 2
+#define MCA_MUL 3
+#define MCA_DIV 4
+
+static void _mca_select_kernels(int mode);
+
+/******************** MCA CONTROL FUNCTIONS *******************
+* The following functions are used to set virtual precision and
+* MCA mode of operation.
+***************************************************************/
+
+static int _set_mca_mode(int mode){
+	if (mode < 0 || mode > 3)
+		return -1;
+
+	int precision = VPREC_PRECISION_NEXT;
+	__atomic_store_n(&VPREC_FLOAT_DROP[mode],
+			 precision < FLOAT_PREC ? FLOAT_PREC - precision : 0, __ATOMIC_RELEASE);
+	__atomic_store_n(&VPREC_DOUBLE_DROP[mode],
+			 precision < DOUBLE_PREC ? DOUBLE_PREC - precision : 0, __ATOMIC_RELEASE);
+	_mca_select_kernels(mode);
+	return 0;
+}
+
+static int _set_mca_precision(int precision){
+	if (precision < 1)
+		return -1;
+
+	VPREC_PRECISION_NEXT = precision;
+	return 0;
+}
+
+/* Reads the rounding from the environment when the backend is loaded */
+static void __attribute__((constructor)) _vprec_init(void) {
+	char * rounding = getenv(VERIFICARLO_VPREC_ROUNDING);
+	int i;
+
+	if (rounding == NULL)
+		return;
+	for (i = 0; i < (int) (sizeof(_vprec_rounding_names) / sizeof(_vprec_rounding_names[0])); i++) {
+		if (strcmp(_vprec_rounding_names[i], rounding) == 0) {
+			VPREC_ROUNDING = i;
+			return;
+		}
+	}
+	fprintf(stderr, VERIFICARLO_VPREC_ROUNDING
+		" invalid value provided, must be NEAREST, ZERO or RANDOM,"
+		" defaulting to NEAREST\n");
+}
+
+static void _mca_seed(const struct vfc_rng_config_t *config) {
+	/* Each thread derives its own stream from the configuration */
+	vfc_rng_seed(config, MCABACKEND_VPREC);
+}
+
+/******************** VIRTUAL PRECISION ROUNDING ******************
+* The low drop bits of the mantissa are cleared after adding:
+* - half of the dropped quantum minus one, plus the lowest kept bit,
+*   to round to nearest with ties to even;
+* - nothing, to round toward zero;
+* - drop random bits, to round up with a probability equal to the
+*   dropped fraction.
+* A carry out of the mantissa increments the exponent, which gives the
+* next power of two, or infinity past the largest finite value.
+*******************************************************************/
+
+#define VPREC_ROUND(uint_t, u, drop) {                                  \
+	uint_t mask = ((uint_t) 1 << (drop)) - 1;                       \
+	switch (VPREC_ROUNDING) {                                       \
+	case VPREC_NEAREST:                                             \
+		u += (mask >> 1) + (((u) >> (drop)) & 1);               \
+		break;                                                  \
+	case VPREC_RANDOM:                                              \
+		u += (uint_t) vfc_rng_uint64() & mask;                  \
+		break;                                                  \
+	}                                                               \
+	u &= ~mask;                                                     \
+}
+
+static inline double _vprec_roundd(double x, int drop) {
+	union {
+		uint64_t u;
+		double d;
+	} hex = { .d = x };
+
+	/* infinities and NaNs are not rounded */
+	if (drop == 0 || (hex.u & DOUBLE_PLUS_INF) == DOUBLE_PLUS_INF)
+		return x;
+	VPREC_ROUND(uint64_t, hex.u, drop);
+	return hex.d;
+}
+
+static inline float _vprec_roundf(float x, int drop) {
+	union {
+		uint32_t u;
+		float f;
+	} hex = { .f = x };
+
+	if (drop == 0 || (hex.u & FLOAT_PLUS_INF) == FLOAT_PLUS_INF)
+		return x;
+	VPREC_ROUND(uint32_t, hex.u, drop);
+	return hex.f;
+}
+
+/******************** MCA ARITHMETIC FUNCTIONS ********************
+* The following set of functions perform the operations at the
+* virtual precision: operands are rounded in the modes with inbound
+* errors, the operation is computed natively, and the result is
+* rounded in the modes with outbound errors.
+* The mode and the operator are compile time constants: each kernel
+* below is specialized for one of them and has no branch on either.
+*******************************************************************/
+
+// perform_bin_op: applies the binary operator (op) to (a) and (b)
+// and stores the result in (res)
+#define perform_bin_op(op, res, a, b)                               \
+    switch (op){                                                    \
+    case MCA_ADD: res=(a)+(b); break;                               \
+    case MCA_MUL: res=(a)*(b); break;                               \
+    case MCA_SUB: res=(a)-(b); break;                               \
+    case MCA_DIV: res=(a)/(b); break;                               \
+    default: perror("invalid operator in mcavprec.\n"); abort();    \
+	};
+
+// inbound and outbound roundings of each mode
+#define MCA_INBOUND(mode)  ((mode) == MCAMODE_MCA || (mode) == MCAMODE_PB)
+#define MCA_OUTBOUND(mode) ((mode) == MCAMODE_MCA || (mode) == MCAMODE_RR)
+
+// MCA_DROP: the bits dropped in the mode, read once by each operation
+#define MCA_DROP(table, mode)                                              \
+	((mode) == MCAMODE_IEEE ? 0 : __atomic_load_n(&table[mode], __ATOMIC_RELAXED))
+
+static inline __attribute__((always_inline))
+float _mca_sbin(float a, float b, const int mode, const int op) {
+	float res = 0;
+
+	const int drop = MCA_DROP(VPREC_FLOAT_DROP, mode);
+
+	if (MCA_INBOUND(mode)) {
+		a = _vprec_roundf(a, drop);
+		b = _vprec_roundf(b, drop);
+	}
+
+	perform_bin_op(op, res, a, b);
+
+	if (MCA_OUTBOUND(mode)) {
+		res = _vprec_roundf(res, drop);
+	}
+
+	return res;
+}
+
+static inline __attribute__((always_inline))
+double _mca_dbin(double a, double b, const int mode, const int op) {
+	double res = 0;
+
+	const int drop = MCA_DROP(VPREC_DOUBLE_DROP, mode);
+
+	if (MCA_INBOUND(mode)) {
+		a = _vprec_roundd(a, drop);
+		b = _vprec_roundd(b, drop);
+	}
+
+	perform_bin_op(op, res, a, b);
+
+	if (MCA_OUTBOUND(mode)) {
+		res = _vprec_roundd(res, drop);
+	}
+
+	return res;
+}
+
+/************************* FPHOOKS FUNCTIONS *************************
+* These functions correspond to those inserted into the source code
+* during source to source compilation and are replacement to floating
+* point operators. MCA_KERNELS defines them for one mode.
+**********************************************************************/
+
+#define MCA_KERNELS(MODE)                                               \
+static float _floatadd_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static float _floatsub_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+static float _floatmul_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+static float _floatdiv_##MODE(float a, float b) {                       \
+	return _mca_sbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}                                                                       \
+static double _doubleadd_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_ADD);                \
+}                                                                       \
+static double _doublesub_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_SUB);                \
+}                                                                       \
+static double _doublemul_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_MUL);                \
+}                                                                       \
+static double _doublediv_##MODE(double a, double b) {                   \
+	return _mca_dbin(a, b, MCAMODE_##MODE, MCA_DIV);                \
+}
+
+MCA_KERNELS(IEEE)
+MCA_KERNELS(MCA)
+MCA_KERNELS(PB)
+MCA_KERNELS(RR)
+
+#define MCA_INTERFACE(MODE) {                                           \
+	_floatadd_##MODE,                                               \
+	_floatsub_##MODE,                                               \
+	_floatmul_##MODE,                                               \
+	_floatdiv_##MODE,                                               \
+	_doubleadd_##MODE,                                              \
+	_doublesub_##MODE,                                              \
+	_doublemul_##MODE,                                              \
+	_doublediv_##MODE,                                              \
+	_mca_seed,                                                      \
+	_set_mca_mode,                                                  \
+	_set_mca_precision                                              \
+}
+
+/* vtables indexed by mode */
+static const struct mca_interface_t _mca_kernels[] = {
+	[MCAMODE_IEEE] = MCA_INTERFACE(IEEE),
+	[MCAMODE_MCA]  = MCA_INTERFACE(MCA),
+	[MCAMODE_PB]   = MCA_INTERFACE(PB),
+	[MCAMODE_RR]   = MCA_INTERFACE(RR),
+};
+
+struct mca_interface_t vprec_mca_interface = MCA_INTERFACE(IEEE);
+
+/* The wrapper copies vprec_mca_interface after setting the mode,
+ * so the instrumented code calls the kernels of that mode */
+static void _mca_select_kernels(int mode) {
+	vprec_mca_interface = _mca_kernels[mode];
+}
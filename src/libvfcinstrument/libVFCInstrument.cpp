@@ -31,15 +31,33 @@
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
 
+#if LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 4
+#include "llvm/DebugInfo.h"
+#else
+#include "llvm/IR/DebugInfo.h"
+#endif
+
 #include <set>
+#include <map>
 #include <fstream>
+#include <sstream>
 
 #if LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 6
 #define CREATE_CALL2(func, op1, op2) (Builder.CreateCall2(func, op1, op2, ""))
 #define CREATE_STRUCT_GEP(t, i, p) (Builder.CreateStructGEP(i, p))
+#define DEBUG_LOC_VALID(dl) (!(dl).isUnknown())
+#define DEBUG_LOC_FILE(dl, ctx) (DIScope((dl).getScope(ctx)).getFilename())
 #else
 #define CREATE_CALL2(func, op1, op2) (Builder.CreateCall(func, {op1, op2}, ""))
 #define CREATE_STRUCT_GEP(t, i, p) (Builder.CreateStructGEP(t, i, p, ""))
+#define DEBUG_LOC_VALID(dl) ((bool)(dl))
+#define DEBUG_LOC_FILE(dl, ctx) (cast<DIScope>((dl).getScope())->getFilename())
+#endif
+
+#if LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR <= 7
+#define SET_NO_TAIL_CALL(call)
+#else
+#define SET_NO_TAIL_CALL(call) (cast<CallInst>(call)->setTailCallKind(CallInst::TCK_NoTail))
 #endif
 
 using namespace llvm;
@@ -52,6 +70,14 @@ static cl::opt<std::string> VfclibInstFunctionFile("vfclibinst-function-file",
 						   cl::desc("Instrument functions in file FunctionNameFile "),
 						   cl::value_desc("FunctionsNameFile"), cl::init(""));
 
+static cl::opt<std::string> VfclibInstSiteProfile("vfclibinst-site-profile",
+						   cl::desc("Only instrument the sites of SiteProfile above the threshold"),
+						   cl::value_desc("SiteProfile"), cl::init(""));
+
+static cl::opt<unsigned> VfclibInstSiteThreshold("vfclibinst-site-threshold",
+						 cl::desc("Bits lost by the sites instrumented with a site profile"),
+						 cl::value_desc("Bits"), cl::init(10));
+
 static cl::opt<bool> VfclibInstVerbose("vfclibinst-verbose",
 				       cl::desc("Activate verbose mode"),
 				       cl::value_desc("Verbose"), cl::init(false));
@@ -71,13 +97,22 @@ namespace {
 
         std::set<std::string> SelectedFunctionSet;
 
+        // Source lines selected by the site profile, by file basename
+        std::map<std::string, std::set<unsigned> > SelectedSiteMap;
+
         VfclibInst() : ModulePass(ID) {
+            // The first word of each line is the function name, so that
+            // site profiles can also be given as functions files
             if (not VfclibInstFunctionFile.empty()) {
                 std::string line;
                 std::ifstream loopstream (VfclibInstFunctionFile.c_str());
                 if (loopstream.is_open()) {
                     while (std::getline(loopstream, line)) {
-                        SelectedFunctionSet.insert(line);
+                        std::string name;
+                        std::istringstream fields(line);
+                        fields >> name;
+                        if (not name.empty() and name[0] != '#')
+                            SelectedFunctionSet.insert(name);
                     }
                     loopstream.close();
                 } else {
@@ -87,6 +122,52 @@ namespace {
             } else if (not VfclibInstFunction.empty()) {
                 SelectedFunctionSet.insert(VfclibInstFunction);
             }
+
+            // A site profile line is: function file:line calls cancelled max_bits
+            if (not VfclibInstSiteProfile.empty()) {
+                std::string line;
+                std::ifstream profilestream (VfclibInstSiteProfile.c_str());
+                if (profilestream.is_open()) {
+                    while (std::getline(profilestream, line)) {
+                        std::string name, location;
+                        unsigned long calls, cancelled;
+                        unsigned bits;
+                        std::istringstream fields(line);
+                        if (not (fields >> name >> location >> calls >> cancelled >> bits)
+                            or name[0] == '#' or bits < VfclibInstSiteThreshold)
+                            continue;
+                        size_t colon = location.rfind(':');
+                        if (colon == std::string::npos) continue;
+                        std::istringstream linestream(location.substr(colon + 1));
+                        unsigned lineno;
+                        if (not (linestream >> lineno)) continue;
+                        SelectedSiteMap[fileBasename(location.substr(0, colon))].insert(lineno);
+                    }
+                    profilestream.close();
+                } else {
+                    errs() << "Cannot open " << VfclibInstSiteProfile << "\n";
+                    assert(0);
+                }
+            }
+        }
+
+        static std::string fileBasename(const std::string &path) {
+            size_t slash = path.rfind('/');
+            return slash == std::string::npos ? path : path.substr(slash + 1);
+        }
+
+        // Returns true if the site profile selects the instruction. The
+        // operations without a source location are never selected.
+        bool isSelectedSite(Module &M, Instruction &I) {
+            if (VfclibInstSiteProfile.empty()) return true;
+
+            const DebugLoc &DL = I.getDebugLoc();
+            if (not DEBUG_LOC_VALID(DL)) return false;
+
+            std::map<std::string, std::set<unsigned> >::iterator site =
+                SelectedSiteMap.find(fileBasename(DEBUG_LOC_FILE(DL, M.getContext())));
+            return site != SelectedSiteMap.end()
+                and site->second.count(DL.getLine()) != 0;
         }
 
         StructType * getMCAInterfaceType(IRBuilder<> &Builder) {
@@ -193,6 +274,10 @@ namespace {
                     vectorName = "2x";
                 } else if (size == 4) {
                     vectorName = "4x";
+                } else if (size == 8) {
+                    vectorName = "8x";
+                } else if (size == 16) {
+                    vectorName = "16x";
                 } else {
                     errs() << "Unsuported vector size: " << size << "\n";
                     assert(0);
@@ -256,6 +341,10 @@ namespace {
                 Instruction *newInst = CREATE_CALL2(
                     fct_ptr,
                     I->getOperand(0), I->getOperand(1));
+                // The SHADOW backend and the cancellation and scope hooks
+                // identify the call site by the return address of the
+                // call, it must stay in the instrumented function
+                SET_NO_TAIL_CALL(newInst);
 
                 return newInst;
             }
@@ -285,8 +374,11 @@ namespace {
                 Instruction &I = *ii;
                 Fops opCode = mustReplace(I);
                 if (opCode == FOP_IGNORE) continue;
+                if (not isSelectedSite(M, I)) continue;
                 if (VfclibInstVerbose) errs() << "Instrumenting" << I << '\n';
                 Instruction *newInst = replaceWithMCACall(M, B, &I, opCode);
+                // Keep the source location, call sites are reported with it
+                newInst->setDebugLoc(I.getDebugLoc());
                 // Remove instruction from parent so it can be
                 // inserted in a new context
                 if (newInst->getParent() != NULL) newInst->removeFromParent();
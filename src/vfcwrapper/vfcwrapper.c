@@ -21,22 +21,65 @@
  *                                                                              *
  ********************************************************************************/
 
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <dlfcn.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <link.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "vfcwrapper.h"
+#include "../common/mca_const.h"
 
 #include "libmca-mpfr.h"
 #include "libmca-quad.h"
+#include "libmca-dd.h"
+#include "libmca-rdround.h"
+#include "libmca-vprec.h"
+#include "libmca-cestac.h"
+#include "libmca-shadow.h"
 
 #define VERIFICARLO_PRECISION "VERIFICARLO_PRECISION"
 #define VERIFICARLO_MCAMODE "VERIFICARLO_MCAMODE"
 #define VERIFICARLO_BACKEND "VERIFICARLO_BACKEND"
+#define VERIFICARLO_BACKEND_PLUGIN "VERIFICARLO_BACKEND_PLUGIN"
+#define VERIFICARLO_CONTROL_FILE "VERIFICARLO_CONTROL_FILE"
+#define VERIFICARLO_CONTROL_POLL "VERIFICARLO_CONTROL_POLL"
+#define VERIFICARLO_PROFILE "VERIFICARLO_PROFILE"
+#define VERIFICARLO_PROFILE_PERIOD "VERIFICARLO_PROFILE_PERIOD"
+#define VERIFICARLO_CANCELLATION "VERIFICARLO_CANCELLATION"
+#define VERIFICARLO_CANCELLATION_THRESHOLD "VERIFICARLO_CANCELLATION_THRESHOLD"
+#define VERIFICARLO_SCOPE "VERIFICARLO_SCOPE"
+#define VERIFICARLO_SEED "VERIFICARLO_SEED"
+#define VERIFICARLO_SAMPLE "VERIFICARLO_SAMPLE"
+#define VERIFICARLO_RNG "VERIFICARLO_RNG"
+#define VERIFICARLO_RNG_BUFFER "VERIFICARLO_RNG_BUFFER"
+#define VERIFICARLO_PROBE_FILE "VERIFICARLO_PROBE_FILE"
+#define VERIFICARLO_PROBE_MAX "VERIFICARLO_PROBE_MAX"
+#define VERIFICARLO_PROBE_SAMPLES "VERIFICARLO_PROBE_SAMPLES"
 #define VERIFICARLO_PRECISION_DEFAULT 53
 #define VERIFICARLO_MCAMODE_DEFAULT MCAMODE_MCA
 #define VERIFICARLO_BACKEND_DEFAULT MCABACKEND_MPFR
+#define VERIFICARLO_CONTROL_POLL_DEFAULT 100
+#define VERIFICARLO_RNG_DEFAULT VFC_RNG_TINYMT
+#define VERIFICARLO_RNG_BUFFER_DEFAULT 256
+#define VERIFICARLO_PROFILE_PERIOD_DEFAULT 64
+#define VERIFICARLO_CANCELLATION_THRESHOLD_DEFAULT 10
+#define VERIFICARLO_PROBE_MAX_DEFAULT 1024
+#define VERIFICARLO_PROBE_SAMPLES_DEFAULT 1024
 
 
 /* Set default values for MCA*/
@@ -47,63 +90,1667 @@ int verificarlo_backend = VERIFICARLO_BACKEND_DEFAULT;
 /* This is the vtable for the current MCA backend */
 struct mca_interface_t _vfc_current_mca_interface;
 
-/* Activates the mpfr MCA backend */
-static void vfc_select_interface_mpfr(void) {
-    _vfc_current_mca_interface = mpfr_mca_interface;
-    _vfc_current_mca_interface.set_mca_precision(verificarlo_precision);
-    _vfc_current_mca_interface.set_mca_mode(verificarlo_mcamode);
+/* Serializes every change of precision, mode or backend */
+static pthread_mutex_t vfc_config_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Random streams configuration, see vfc_rng.h */
+static __thread int vfc_rng_thread_id = -1;
+
+static int vfc_rng_thread(void) {
+    return vfc_rng_thread_id;
+}
+
+/* call site of the instrumented operation recorded by the vector wrapper
+ * or hook running, 0 outside of them, see VFC_CALLER_ENTER */
+static __thread uintptr_t vfc_caller = 0;
+
+static uintptr_t vfc_caller_site(void) {
+    return vfc_caller;
+}
+
+static struct vfc_rng_config_t vfc_rng_config = { 0, 0, 0, VERIFICARLO_RNG_DEFAULT,
+                                                   VERIFICARLO_RNG_BUFFER_DEFAULT,
+                                                   vfc_rng_thread, vfc_caller_site };
+static int vfc_seed_is_set = 0;
+
+static const char * vfc_rng_names[] = { "TINYMT", "PHILOX", "XOSHIRO" };
+
+/* Control file polled by the reconfiguration thread, NULL if disabled */
+static char * vfc_control_file = NULL;
+
+/* MCA backends registry, indexed by MCABACKEND_*.
+ *
+ * Backends are shared libraries loaded with dlopen the first time they are
+ * selected, so that a run only loads and seeds the backend it uses. Static
+ * binaries cannot dlopen: verificarlo then links the backends requested with
+ * --static-backends and defines VFC_STATIC_<NAME> for each of them. */
+struct vfc_backend_t {
+    const char * name;                  /* VERIFICARLO_BACKEND value */
+    const char * library;               /* shared library implementing it */
+    const char * symbol;                /* mca_interface_t exported by library */
+    struct mca_interface_t * interface; /* NULL until the backend is loaded */
+    int initialized;                    /* set once the backend is seeded */
+};
+
+static struct vfc_backend_t vfc_backends[] = {
+    [MCABACKEND_QUAD] = { "QUAD", "libmcaquad.so", "quad_mca_interface",
+#ifdef VFC_STATIC_QUAD
+                          &quad_mca_interface,
+#endif
+                        },
+    [MCABACKEND_MPFR] = { "MPFR", "libmcampfr.so", "mpfr_mca_interface",
+#ifdef VFC_STATIC_MPFR
+                          &mpfr_mca_interface,
+#endif
+                        },
+    [MCABACKEND_RDROUND] = { "RDROUND", "libmcardround.so", "rdround_mca_interface",
+#ifdef VFC_STATIC_RDROUND
+                          &rdround_mca_interface,
+#endif
+                        },
+    [MCABACKEND_DD]   = { "DD", "libmcadd.so", "dd_mca_interface",
+#ifdef VFC_STATIC_DD
+                          &dd_mca_interface,
+#endif
+                        },
+    [MCABACKEND_VPREC] = { "VPREC", "libmcavprec.so", "vprec_mca_interface",
+#ifdef VFC_STATIC_VPREC
+                          &vprec_mca_interface,
+#endif
+                        },
+    [MCABACKEND_CESTAC] = { "CESTAC", "libmcacestac.so", "cestac_mca_interface",
+#ifdef VFC_STATIC_CESTAC
+                          &cestac_mca_interface,
+#endif
+                        },
+    /* not a library: selects QUAD, MPFR or DD by type, see vfc_auto_select */
+    [MCABACKEND_AUTO] = { "AUTO" },
+    /* library given by VERIFICARLO_BACKEND_PLUGIN, see vfc_plugin_load */
+    [MCABACKEND_PLUGIN] = { "PLUGIN", NULL, VFC_PLUGIN_SYMBOL },
+    [MCABACKEND_SHADOW] = { "SHADOW", "libmcashadow.so", "shadow_mca_interface",
+#ifdef VFC_STATIC_SHADOW
+                          &shadow_mca_interface,
+#endif
+                        },
+};
+
+#define VFC_BACKENDS_COUNT ((int) (sizeof(vfc_backends) / sizeof(vfc_backends[0])))
+
+/******************** BACKEND PLUGINS **************************
+* The PLUGIN backend is a struct vfc_plugin_t exported by the library
+* given by VERIFICARLO_BACKEND_PLUGIN (see vfcwrapper.h). Its entries
+* are copied into vfc_plugin_interface, the vtable registered for
+* the backend, after each call to its set_mca_mode and
+* set_mca_precision entries. An optional entry is copied only when
+* the plugin advertises its capability and its structure holds it,
+* NULL otherwise so that the wrappers use the scalar entries.
+***************************************************************/
+
+#ifndef VFC_STATIC_BACKENDS
+static struct vfc_plugin_t * vfc_plugin = NULL;
+static struct mca_interface_t vfc_plugin_interface;
+
+/* 1 if the plugin structure is large enough to hold field */
+#define VFC_PLUGIN_HAS(p, field)                                            \
+    ((p)->size >= offsetof(struct vfc_plugin_t, field) + sizeof((p)->field))
+
+/* optional entry of the plugin, NULL if it does not provide it */
+#define VFC_PLUGIN_OPTIONAL(p, cap, field)                                  \
+    (((p)->caps & (cap)) && VFC_PLUGIN_HAS(p, field) ? (p)->field : NULL)
+
+/* Copies the current entries of the plugin into its vtable */
+static void vfc_plugin_update(void) {
+    struct vfc_plugin_t * p = vfc_plugin;
+    struct mca_interface_t * i = &vfc_plugin_interface;
+
+    i->floatadd = p->floatadd;
+    i->floatsub = p->floatsub;
+    i->floatmul = p->floatmul;
+    i->floatdiv = p->floatdiv;
+    i->doubleadd = p->doubleadd;
+    i->doublesub = p->doublesub;
+    i->doublemul = p->doublemul;
+    i->doublediv = p->doublediv;
+    i->floatadd_vector = VFC_PLUGIN_OPTIONAL(p, VFC_PLUGIN_CAP_VECTOR, floatadd_vector);
+    i->floatsub_vector = VFC_PLUGIN_OPTIONAL(p, VFC_PLUGIN_CAP_VECTOR, floatsub_vector);
+    i->floatmul_vector = VFC_PLUGIN_OPTIONAL(p, VFC_PLUGIN_CAP_VECTOR, floatmul_vector);
+    i->floatdiv_vector = VFC_PLUGIN_OPTIONAL(p, VFC_PLUGIN_CAP_VECTOR, floatdiv_vector);
+    i->floatdigits = VFC_PLUGIN_OPTIONAL(p, VFC_PLUGIN_CAP_DIGITS, floatdigits);
+    i->doubledigits = VFC_PLUGIN_OPTIONAL(p, VFC_PLUGIN_CAP_DIGITS, doubledigits);
+}
+
+static int vfc_plugin_set_mode(int mode) {
+    int ret = vfc_plugin->set_mca_mode(mode);
+    vfc_plugin_update();
+    return ret;
+}
+
+static int vfc_plugin_set_precision(int precision) {
+    int ret = vfc_plugin->set_mca_precision(precision);
+    vfc_plugin_update();
+    return ret;
+}
+
+/* registered with atexit once the plugin is initialized */
+static void vfc_plugin_teardown(void) {
+    if (vfc_plugin->teardown != NULL)
+        vfc_plugin->teardown();
+}
+
+/* Loads and initializes the plugin. Returns its vtable, or NULL if the
+ * library cannot be loaded or is not a compatible plugin. */
+static struct mca_interface_t * vfc_plugin_load(void) {
+    const char * path = getenv(VERIFICARLO_BACKEND_PLUGIN);
+    if (path == NULL) {
+        fprintf(stderr, "PLUGIN backend requires " VERIFICARLO_BACKEND_PLUGIN "\n");
+        return NULL;
+    }
+
+    void * handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, "Cannot load PLUGIN backend: %s\n", dlerror());
+        return NULL;
+    }
+
+    struct vfc_plugin_t * p = dlsym(handle, VFC_PLUGIN_SYMBOL);
+    const char * error = NULL;
+    if (p == NULL) {
+        error = dlerror();
+    } else if (p->version != VFC_PLUGIN_VERSION) {
+        error = "unsupported plugin version";
+    } else if (!VFC_PLUGIN_HAS(p, doublediv)) {
+        error = "plugin structure too small";
+    } else if (p->seed == NULL || p->set_mca_mode == NULL || p->set_mca_precision == NULL
+               || p->floatadd == NULL || p->floatsub == NULL
+               || p->floatmul == NULL || p->floatdiv == NULL
+               || p->doubleadd == NULL || p->doublesub == NULL
+               || p->doublemul == NULL || p->doublediv == NULL) {
+        error = "missing mandatory entry";
+    } else if (p->init != NULL && p->init() != 0) {
+        error = "plugin initialization failed";
+    }
+    if (error != NULL) {
+        fprintf(stderr, "Cannot load PLUGIN backend %s: %s\n", path, error);
+        dlclose(handle);
+        return NULL;
+    }
+
+    vfc_plugin = p;
+    vfc_plugin_interface.seed = p->seed;
+    vfc_plugin_interface.set_mca_mode = vfc_plugin_set_mode;
+    vfc_plugin_interface.set_mca_precision = vfc_plugin_set_precision;
+    vfc_plugin_update();
+    atexit(vfc_plugin_teardown);
+    return &vfc_plugin_interface;
+}
+#endif
+
+#ifndef VFC_STATIC_BACKENDS
+/* Loads the library of an in-tree backend. Returns its vtable, or NULL if
+ * it cannot be loaded. */
+static struct mca_interface_t * vfc_library_load(struct vfc_backend_t * b) {
+    char path[PATH_MAX];
+#ifdef VFC_LIBDIR
+    snprintf(path, sizeof(path), "%s/%s", VFC_LIBDIR, b->library);
+#else
+    snprintf(path, sizeof(path), "%s", b->library);
+#endif
+    void * handle = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (handle == NULL) {
+        fprintf(stderr, "Cannot load %s backend: %s\n", b->name, dlerror());
+        return NULL;
+    }
+    struct mca_interface_t * interface = dlsym(handle, b->symbol);
+    if (interface == NULL) {
+        fprintf(stderr, "Cannot load %s backend: %s\n", b->name, dlerror());
+        dlclose(handle);
+    }
+    return interface;
+}
+#endif
+
+/* Returns the seeded vtable of a backend, loading it if needed.
+ * Returns NULL if the backend is not available. */
+static struct mca_interface_t * vfc_backend_get(int backend) {
+    if (backend < 0 || backend >= VFC_BACKENDS_COUNT || backend == MCABACKEND_AUTO)
+        return NULL;
+
+    struct vfc_backend_t * b = &vfc_backends[backend];
+    if (b->interface == NULL) {
+#ifdef VFC_STATIC_BACKENDS
+        fprintf(stderr, "%s backend is not linked in this static binary\n", b->name);
+        return NULL;
+#else
+        if (backend == MCABACKEND_PLUGIN)
+            b->interface = vfc_plugin_load();
+        else
+            b->interface = vfc_library_load(b);
+        if (b->interface == NULL)
+            return NULL;
+#endif
+    }
+
+    if (!b->initialized) {
+        b->interface->seed(&vfc_rng_config);
+        b->initialized = 1;
+    }
+    return b->interface;
+}
+
+/* Copies a vtable into dst. Instrumented code may be running concurrently
+ * in other threads: each entry is published with an atomic store so that a
+ * thread always calls either the old or the new function, never a torn
+ * pointer. */
+static void vfc_publish_interface(struct mca_interface_t *dst,
+                                  const struct mca_interface_t *src) {
+    __atomic_store_n(&dst->floatadd, src->floatadd, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatsub, src->floatsub, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatmul, src->floatmul, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatdiv, src->floatdiv, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->doubleadd, src->doubleadd, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->doublesub, src->doublesub, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->doublemul, src->doublemul, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->doublediv, src->doublediv, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->seed, src->seed, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->set_mca_mode, src->set_mca_mode, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->set_mca_precision, src->set_mca_precision, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatadd_vector, src->floatadd_vector, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatsub_vector, src->floatsub_vector, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatmul_vector, src->floatmul_vector, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatdiv_vector, src->floatdiv_vector, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->floatdigits, src->floatdigits, __ATOMIC_RELEASE);
+    __atomic_store_n(&dst->doubledigits, src->doubledigits, __ATOMIC_RELEASE);
+}
+
+/* backends selected by AUTO for the float and double operations */
+static int vfc_auto_float = MCABACKEND_MPFR;
+static int vfc_auto_double = MCABACKEND_MPFR;
+
+/******************** CALL SITES *******************************
+* The cancellation and scope hooks and the SHADOW backend identify
+* an operation by its call site, the return address of the function
+* the instrumented code calls. When a vector wrapper or a hook calls
+* the next layer, the outermost one records its own return address
+* in vfc_caller for the layers behind it. It is only recorded when
+* one of them reads it.
+***************************************************************/
+
+/* set when the installed hooks or backend read vfc_caller */
+static int vfc_caller_recorded = 0;
+
+#define VFC_CALLER_ENTER()                                                 \
+    int vfc_caller_owner =                                                 \
+        __atomic_load_n(&vfc_caller_recorded, __ATOMIC_RELAXED)            \
+        && vfc_caller == 0;                                                \
+    if (vfc_caller_owner)                                                  \
+        vfc_caller = (uintptr_t)                                           \
+            __builtin_extract_return_addr(__builtin_return_address(0)) - 1
+
+#define VFC_CALLER_LEAVE()                                                 \
+    if (vfc_caller_owner)                                                  \
+        vfc_caller = 0
+
+#define VFC_HOOK_SITE()                                                    \
+    (vfc_caller != 0 ? vfc_caller : (uintptr_t)                            \
+        __builtin_extract_return_addr(__builtin_return_address(0)) - 1)
+
+/******************** PROFILING ********************************
+* When VERIFICARLO_PROFILE is set, the arithmetic entries of
+* _vfc_current_mca_interface are replaced by hooks which count the
+* calls per vtable entry and forward them to the backend. One call
+* every VERIFICARLO_PROFILE_PERIOD is timed with a cycle counter.
+* A JSON report is written to VERIFICARLO_PROFILE at exit.
+***************************************************************/
+
+/* vtable entries profiled, in mca_interface_t order */
+enum { VFC_PROFILE_FLOATADD, VFC_PROFILE_FLOATSUB, VFC_PROFILE_FLOATMUL,
+       VFC_PROFILE_FLOATDIV, VFC_PROFILE_DOUBLEADD, VFC_PROFILE_DOUBLESUB,
+       VFC_PROFILE_DOUBLEMUL, VFC_PROFILE_DOUBLEDIV, VFC_PROFILE_ENTRIES };
+
+static const char * vfc_mode_names[] = { "IEEE", "MCA", "PB", "RR", "REF" };
+
+/* per-thread counters, chained so that the report can sum them */
+struct vfc_profile_counters {
+    uint64_t calls[VFC_PROFILE_ENTRIES];
+    uint64_t sampled[VFC_PROFILE_ENTRIES];
+    uint64_t cycles[VFC_PROFILE_ENTRIES];
+    uint64_t countdown[VFC_PROFILE_ENTRIES];
+    struct vfc_profile_counters * next;
+};
+
+/* Report path, NULL when profiling is disabled */
+static char * vfc_profile_file = NULL;
+static uint64_t vfc_profile_period = VERIFICARLO_PROFILE_PERIOD_DEFAULT;
+static struct vfc_profile_counters * vfc_profile_threads = NULL;
+static pthread_mutex_t vfc_profile_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct vfc_profile_counters * vfc_profile_local = NULL;
+
+/* Backend vtable called by the profiling hooks */
+static struct mca_interface_t vfc_profiled_interface;
+
+static inline uint64_t vfc_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    uint32_t lo, hi;
+    __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+    return ((uint64_t) hi << 32) | lo;
+#else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000ULL + t.tv_nsec;
+#endif
+}
+
+static struct vfc_profile_counters * vfc_profile_register_thread(void) {
+    struct vfc_profile_counters * c = calloc(1, sizeof(*c));
+    if (c == NULL) {
+        perror("Cannot allocate profiling counters\n");
+        abort();
+    }
+    pthread_mutex_lock(&vfc_profile_lock);
+    c->next = vfc_profile_threads;
+    vfc_profile_threads = c;
+    pthread_mutex_unlock(&vfc_profile_lock);
+    vfc_profile_local = c;
+    return c;
+}
+
+#define VFC_PROFILE_HOOK(type, op, entry)                                  \
+    static type vfc_profile_##type##op(type a, type b) {                   \
+        struct vfc_profile_counters * c = vfc_profile_local;               \
+        if (c == NULL) c = vfc_profile_register_thread();                  \
+        type res;                                                          \
+        VFC_CALLER_ENTER();                                                \
+        c->calls[entry]++;                                                 \
+        if (c->countdown[entry]-- != 0) {                                  \
+            res = vfc_profiled_interface.type##op(a, b);                   \
+        } else {                                                           \
+            c->countdown[entry] = vfc_profile_period - 1;                  \
+            uint64_t start = vfc_cycles();                                 \
+            res = vfc_profiled_interface.type##op(a, b);                   \
+            c->cycles[entry] += vfc_cycles() - start;                      \
+            c->sampled[entry]++;                                           \
+        }                                                                  \
+        VFC_CALLER_LEAVE();                                                \
+        return res;                                                        \
+    }
+
+VFC_PROFILE_HOOK(float, add, VFC_PROFILE_FLOATADD)
+VFC_PROFILE_HOOK(float, sub, VFC_PROFILE_FLOATSUB)
+VFC_PROFILE_HOOK(float, mul, VFC_PROFILE_FLOATMUL)
+VFC_PROFILE_HOOK(float, div, VFC_PROFILE_FLOATDIV)
+VFC_PROFILE_HOOK(double, add, VFC_PROFILE_DOUBLEADD)
+VFC_PROFILE_HOOK(double, sub, VFC_PROFILE_DOUBLESUB)
+VFC_PROFILE_HOOK(double, mul, VFC_PROFILE_DOUBLEMUL)
+VFC_PROFILE_HOOK(double, div, VFC_PROFILE_DOUBLEDIV)
+
+/* Writes the profiling report, registered with atexit */
+static void vfc_profile_report(void) {
+    static const char * types[] = { "float", "double" };
+    static const char * ops[] = { "add", "sub", "mul", "div" };
+    uint64_t calls[VFC_PROFILE_ENTRIES] = { 0 };
+    uint64_t sampled[VFC_PROFILE_ENTRIES] = { 0 };
+    uint64_t cycles[VFC_PROFILE_ENTRIES] = { 0 };
+    uint64_t total = 0;
+    int threads = 0;
+    int t, o;
+
+    pthread_mutex_lock(&vfc_profile_lock);
+    struct vfc_profile_counters * c;
+    for (c = vfc_profile_threads; c != NULL; c = c->next, threads++) {
+        for (t = 0; t < VFC_PROFILE_ENTRIES; t++) {
+            calls[t] += c->calls[t];
+            sampled[t] += c->sampled[t];
+            cycles[t] += c->cycles[t];
+            total += c->calls[t];
+        }
+    }
+    pthread_mutex_unlock(&vfc_profile_lock);
+
+    FILE * f = fopen(vfc_profile_file, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write profile to %s\n", vfc_profile_file);
+        return;
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"backend\": \"%s\",\n", vfc_backends[verificarlo_backend].name);
+    if (verificarlo_backend == MCABACKEND_AUTO) {
+        fprintf(f, "  \"float_backend\": \"%s\",\n", vfc_backends[vfc_auto_float].name);
+        fprintf(f, "  \"double_backend\": \"%s\",\n", vfc_backends[vfc_auto_double].name);
+    }
+#ifndef VFC_STATIC_BACKENDS
+    if (verificarlo_backend == MCABACKEND_PLUGIN && vfc_plugin != NULL && vfc_plugin->name != NULL)
+        fprintf(f, "  \"plugin\": \"%s\",\n", vfc_plugin->name);
+#endif
+    fprintf(f, "  \"mode\": \"%s\",\n", vfc_mode_names[verificarlo_mcamode]);
+    fprintf(f, "  \"precision\": %d,\n", verificarlo_precision);
+    fprintf(f, "  \"threads\": %d,\n", threads);
+    fprintf(f, "  \"sampling_period\": %llu,\n", (unsigned long long) vfc_profile_period);
+    fprintf(f, "  \"calls\": %llu,\n", (unsigned long long) total);
+    fprintf(f, "  \"operations\": {\n");
+    for (t = 0; t < 2; t++) {
+        fprintf(f, "    \"%s\": {\n", types[t]);
+        for (o = 0; o < 4; o++) {
+            int e = t * 4 + o;
+            double per_call = sampled[e] ? (double) cycles[e] / sampled[e] : 0;
+            fprintf(f, "      \"%s\": { \"calls\": %llu, \"sampled\": %llu, "
+                    "\"cycles_per_call\": %.1f, \"estimated_cycles\": %.0f }%s\n",
+                    ops[o], (unsigned long long) calls[e],
+                    (unsigned long long) sampled[e], per_call,
+                    per_call * calls[e], o < 3 ? "," : "");
+        }
+        fprintf(f, "    }%s\n", t < 1 ? "," : "");
+    }
+    fprintf(f, "  }\n");
+    fprintf(f, "}\n");
+    fclose(f);
 }
 
-/* Activates the quad MCA backend */
-static void vfc_select_interface_quad(void) {
-    _vfc_current_mca_interface = quad_mca_interface;
-    _vfc_current_mca_interface.set_mca_precision(verificarlo_precision);
-    _vfc_current_mca_interface.set_mca_mode(verificarlo_mcamode);
+/******************** CANCELLATIONS ***************************
+* When VERIFICARLO_CANCELLATION is set, the add and sub entries of
+* _vfc_current_mca_interface are replaced by hooks which compare
+* the exponent of the result of each operation with the largest
+* exponent of its operands: their difference is the number of bits
+* lost by cancellation, read from the bits of the values. Each
+* thread counts the operations of each call site in a histogram of
+* bits lost, in an array indexed by the number given to the site in
+* a shared table and grown to the sites the thread has seen. The
+* call site is the return address of the hook.
+* The sites are ranked at exit, in the file given by
+* VERIFICARLO_CANCELLATION, by the number of operations losing at
+* least VERIFICARLO_CANCELLATION_THRESHOLD bits.
+***************************************************************/
+
+#define VFC_CANCEL_SITES 4096  /* call sites recorded, a power of two */
+#define VFC_CANCEL_BUCKETS 64  /* bits lost, the last bucket holds 63 or more */
+
+/* (address << 16) | (index + 1), where the index numbers the sites in the
+ * order they are inserted, address << 16 while the index is drawn, 0 if
+ * the slot is free */
+static uint64_t vfc_cancel_sites[VFC_CANCEL_SITES];
+static uint32_t vfc_cancel_count = 0;
+static int vfc_cancel_full = 0;
+
+/* per-thread histograms, chained so that the report can sum them */
+struct vfc_cancel_counters {
+    uint64_t (*hist)[VFC_CANCEL_BUCKETS]; /* indexed by site index */
+    uint32_t size;                        /* sites held by hist */
+    struct vfc_cancel_counters * next;
+};
+
+/* Report path, NULL when the cancellations are not counted */
+static char * vfc_cancel_file = NULL;
+static int vfc_cancel_threshold = VERIFICARLO_CANCELLATION_THRESHOLD_DEFAULT;
+static struct vfc_cancel_counters * vfc_cancel_threads = NULL;
+static pthread_mutex_t vfc_cancel_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct vfc_cancel_counters * vfc_cancel_local = NULL;
+
+/* Backend vtable, or profiling hooks, called by the cancellation hooks */
+static struct mca_interface_t vfc_cancel_next;
+
+/* the histograms are allocated by vfc_cancel_grow */
+static struct vfc_cancel_counters * vfc_cancel_register_thread(void) {
+    struct vfc_cancel_counters * c = calloc(1, sizeof(*c));
+    if (c == NULL) {
+        perror("Cannot allocate cancellation counters\n");
+        abort();
+    }
+    pthread_mutex_lock(&vfc_cancel_lock);
+    c->next = vfc_cancel_threads;
+    vfc_cancel_threads = c;
+    pthread_mutex_unlock(&vfc_cancel_lock);
+    vfc_cancel_local = c;
+    return c;
 }
 
+/* Grows the histograms of a thread to hold the site index */
+static void __attribute__((noinline)) vfc_cancel_grow(struct vfc_cancel_counters * c,
+                                                      int index) {
+    uint32_t size = c->size != 0 ? c->size : 16;
+    while (size <= (uint32_t) index)
+        size *= 2;
 
+    /* the report may be summing the histograms */
+    pthread_mutex_lock(&vfc_cancel_lock);
+    uint64_t (*hist)[VFC_CANCEL_BUCKETS] = realloc(c->hist, size * sizeof(*hist));
+    if (hist == NULL) {
+        perror("Cannot allocate cancellation counters\n");
+        abort();
+    }
+    memset(hist + c->size, 0, (size - c->size) * sizeof(*hist));
+    c->hist = hist;
+    c->size = size;
+    pthread_mutex_unlock(&vfc_cancel_lock);
+}
 
+/* Returns the index of a site whose slot is reserved, waiting for the
+ * thread that reserved it to publish the index */
+static int __attribute__((noinline)) vfc_cancel_wait(uint32_t slot) {
+    uint64_t s;
+    while (((s = __atomic_load_n(&vfc_cancel_sites[slot], __ATOMIC_ACQUIRE)) & 0xffff) == 0)
+        ;
+    return (int) (s & 0xffff) - 1;
+}
 
-/* seeds all the MCA backends */
+/* Returns the index of a call site, -1 if the table is full. A new site
+ * is first inserted as address << 16, reserving its slot, and its index
+ * is drawn and published by the thread that won the reservation: the
+ * indexes are dense and the table is only full when every slot is. */
+static inline int vfc_cancel_site(uintptr_t address) {
+    uint32_t h = (uint32_t) ((address * UINT64_C(0x9e3779b97f4a7c15)) >> 40);
+    uint32_t i;
+
+    for (i = 0; i < VFC_CANCEL_SITES; i++) {
+        uint32_t slot = (h + i) & (VFC_CANCEL_SITES - 1);
+        uint64_t s = __atomic_load_n(&vfc_cancel_sites[slot], __ATOMIC_ACQUIRE);
+        if (__builtin_expect((s >> 16) == address, 1))
+            return (s & 0xffff) != 0 ? (int) (s & 0xffff) - 1 : vfc_cancel_wait(slot);
+        if (s == 0) {
+            uint64_t expected = 0;
+            if (__atomic_compare_exchange_n(&vfc_cancel_sites[slot], &expected,
+                                            (uint64_t) address << 16, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                uint32_t index = __atomic_fetch_add(&vfc_cancel_count, 1, __ATOMIC_RELAXED);
+                __atomic_store_n(&vfc_cancel_sites[slot],
+                                 ((uint64_t) address << 16) | (index + 1), __ATOMIC_RELEASE);
+                return index;
+            }
+            if ((expected >> 16) == address)
+                return vfc_cancel_wait(slot);
+        }
+    }
+    vfc_cancel_full = 1;
+    return -1;
+}
+
+/* Bits lost by an operation, from the biased exponents of its operands
+ * and result. A zero result of nonzero operands loses every bit. */
+static inline int vfc_cancel_bits(int ea, int eb, int er, int emax) {
+    int e = ea > eb ? ea : eb;
+    if (e == emax || er == emax || er >= e)
+        return 0;
+    return e - er < VFC_CANCEL_BUCKETS ? e - er : VFC_CANCEL_BUCKETS - 1;
+}
+
+static inline int vfc_cancel_dexp(double x) {
+    union { double d; uint64_t u; } hex = { .d = x };
+    return (hex.u >> 52) & 0x7ff;
+}
+
+static inline int vfc_cancel_fexp(float x) {
+    union { float f; uint32_t u; } hex = { .f = x };
+    return (hex.u >> 23) & 0xff;
+}
+
+#define VFC_CANCEL_HOOK(type, op, exp, emax)                               \
+    static type vfc_cancel_##type##op(type a, type b) {                    \
+        VFC_CALLER_ENTER();                                                \
+        type r = vfc_cancel_next.type##op(a, b);                           \
+        struct vfc_cancel_counters * c = vfc_cancel_local;                 \
+        if (c == NULL) c = vfc_cancel_register_thread();                   \
+        int site = vfc_cancel_site(VFC_HOOK_SITE());                       \
+        if (site >= 0) {                                                   \
+            if ((uint32_t) site >= c->size)                                \
+                vfc_cancel_grow(c, site);                                  \
+            c->hist[site][vfc_cancel_bits(exp(a), exp(b), exp(r), emax)]++; \
+        }                                                                  \
+        VFC_CALLER_LEAVE();                                                \
+        return r;                                                          \
+    }
+
+VFC_CANCEL_HOOK(float, add, vfc_cancel_fexp, 0xff)
+VFC_CANCEL_HOOK(float, sub, vfc_cancel_fexp, 0xff)
+VFC_CANCEL_HOOK(double, add, vfc_cancel_dexp, 0x7ff)
+VFC_CANCEL_HOOK(double, sub, vfc_cancel_dexp, 0x7ff)
+
+/* object file of a call site, and the address addr2line expects in it */
+struct vfc_site_object {
+    uintptr_t address;
+    const char * name;
+    uintptr_t offset;
+};
+
+static int vfc_site_object_find(struct dl_phdr_info * info, size_t size, void * data) {
+    struct vfc_site_object * o = data;
+    int i;
+
+    for (i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) * p = &info->dlpi_phdr[i];
+        uintptr_t start = info->dlpi_addr + p->p_vaddr;
+        if (p->p_type == PT_LOAD && o->address >= start && o->address < start + p->p_memsz) {
+            o->name = info->dlpi_name;
+            o->offset = o->address - info->dlpi_addr;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* site summary, for ranking */
+struct vfc_cancel_summary {
+    uintptr_t address;
+    int index;
+    uint64_t calls;
+    uint64_t cancellations; /* operations losing at least the threshold */
+    int max_bits;
+};
+
+static int vfc_cancel_compare(const void * a, const void * b) {
+    const struct vfc_cancel_summary * x = a, * y = b;
+    if (x->cancellations != y->cancellations)
+        return x->cancellations < y->cancellations ? 1 : -1;
+    if (x->max_bits != y->max_bits)
+        return x->max_bits < y->max_bits ? 1 : -1;
+    return x->calls < y->calls ? 1 : x->calls > y->calls ? -1 : 0;
+}
+
+/* Writes the cancellation report, registered with atexit */
+static void vfc_cancel_report(void) {
+    static struct vfc_cancel_summary sites[VFC_CANCEL_SITES];
+    uint64_t (*hist)[VFC_CANCEL_BUCKETS] = calloc(VFC_CANCEL_SITES, sizeof(*hist));
+    int n = 0, i, k;
+
+    if (hist == NULL) {
+        perror("Cannot allocate cancellation report\n");
+        return;
+    }
+
+    pthread_mutex_lock(&vfc_cancel_lock);
+    struct vfc_cancel_counters * c;
+    uint32_t j;
+    for (c = vfc_cancel_threads; c != NULL; c = c->next) {
+        for (j = 0; j < c->size && j < VFC_CANCEL_SITES; j++) {
+            for (k = 0; k < VFC_CANCEL_BUCKETS; k++)
+                hist[j][k] += c->hist[j][k];
+        }
+    }
+    pthread_mutex_unlock(&vfc_cancel_lock);
+
+    for (i = 0; i < VFC_CANCEL_SITES; i++) {
+        uint64_t site = vfc_cancel_sites[i];
+        if ((site & 0xffff) == 0)
+            continue;
+        struct vfc_cancel_summary * s = &sites[n++];
+        s->address = site >> 16;
+        s->index = (int) (site & 0xffff) - 1;
+        for (k = 0; k < VFC_CANCEL_BUCKETS; k++) {
+            s->calls += hist[s->index][k];
+            if (k >= vfc_cancel_threshold)
+                s->cancellations += hist[s->index][k];
+            if (hist[s->index][k] != 0)
+                s->max_bits = k;
+        }
+    }
+    qsort(sites, n, sizeof(sites[0]), vfc_cancel_compare);
+
+    FILE * f = fopen(vfc_cancel_file, "w");
+    if (f == NULL) {
+        fprintf(stderr, "Cannot write cancellations to %s\n", vfc_cancel_file);
+        free(hist);
+        return;
+    }
+
+    char exe[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    exe[len > 0 ? len : 0] = '\0';
+
+    if (vfc_cancel_full)
+        fprintf(f, "# more than %d sites, some are not reported\n", VFC_CANCEL_SITES);
+    fprintf(f, "# sites ranked by the operations losing at least %d bits\n",
+            vfc_cancel_threshold);
+    fprintf(f, "# %-11s %12s %8s  %-18s %-24s %s\n", "cancelled", "calls", "max_bits",
+            "address", "object", "histogram (bits:calls)");
+    for (i = 0; i < n; i++) {
+        struct vfc_site_object o = { sites[i].address, NULL, 0 };
+        const char * object = "?";
+        if (dl_iterate_phdr(vfc_site_object_find, &o) != 0)
+            object = o.name[0] != '\0' ? o.name : exe;
+        else
+            o.offset = o.address;
+
+        fprintf(f, "%-13llu %12llu %8d  0x%-16lx %-24s",
+                (unsigned long long) sites[i].cancellations,
+                (unsigned long long) sites[i].calls, sites[i].max_bits,
+                (unsigned long) o.offset, object);
+        for (k = 0; k < VFC_CANCEL_BUCKETS; k++) {
+            if (hist[sites[i].index][k] != 0)
+                fprintf(f, " %d:%llu", k, (unsigned long long) hist[sites[i].index][k]);
+        }
+        fprintf(f, "\n");
+    }
+    fclose(f);
+    free(hist);
+}
+
+/******************** SCOPE ************************************
+* When VERIFICARLO_SCOPE is set, only the functions listed in the
+* file it names go through the backend, the operations of the other
+* instrumented functions are computed natively: a fully instrumented
+* binary can be restricted to any set of functions without being
+* rebuilt. A line gives a function name, optionally followed by a
+* precision in bits at which the results of the function are then
+* rounded to nearest, after the backend, to emulate a narrower type.
+*
+* The hooks identify the function of a call site, the return address
+* of the hook or of the vector wrapper calling it, from the symbol
+* table of its object file. The answer is cached in a shared table
+* of sites, packed with the address in a single word so that it is
+* inserted with one compare and swap.
+***************************************************************/
+
+#define VFC_SCOPE_SITES 4096   /* call sites cached, a power of two */
+#define VFC_SCOPE_OUTSIDE 1    /* cached code of the sites out of the scope */
+
+struct vfc_scope_entry {
+    char * name;
+    int precision;  /* 0 keeps the results of the backend */
+};
+
+/* function of the scope loaded in memory */
+struct vfc_scope_range {
+    uintptr_t start;
+    uintptr_t end;
+    int entry;
+};
+
+/* Scope path, NULL when every instrumented function is in the scope */
+static char * vfc_scope_file = NULL;
+static struct vfc_scope_entry * vfc_scope_entries = NULL;
+static int vfc_scope_size = 0;
+
+/* ranges of the objects already read, guarded by vfc_scope_lock */
+static struct vfc_scope_range * vfc_scope_ranges = NULL;
+static int vfc_scope_nranges = 0;
+static uintptr_t * vfc_scope_objects = NULL;
+static int vfc_scope_nobjects = 0;
+static pthread_mutex_t vfc_scope_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* (address << 16) | (entry + 2), or VFC_SCOPE_OUTSIDE, 0 if the slot is free */
+static uint64_t vfc_scope_sites[VFC_SCOPE_SITES];
+
+/* Backend vtable, or profiling hooks, called by the scope hooks */
+static struct mca_interface_t vfc_scope_next;
+
+static int vfc_scope_compare(const void * a, const void * b) {
+    return strcmp(((const struct vfc_scope_entry *) a)->name,
+                  ((const struct vfc_scope_entry *) b)->name);
+}
+
+/* Reads the scope file, returns -1 on failure */
+static int vfc_scope_parse(const char * path) {
+    char line[1024];
+    int capacity = 0;
+    FILE * f = fopen(path, "r");
+
+    if (f == NULL) {
+        fprintf(stderr, "Cannot open " VERIFICARLO_SCOPE " %s\n", path);
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL) {
+        char name[1024];
+        int precision = 0;
+        int n = sscanf(line, "%1023s %d", name, &precision);
+        if (n < 1 || name[0] == '#')
+            continue;
+        if (n == 2 && precision < 1) {
+            fprintf(stderr, VERIFICARLO_SCOPE " invalid precision for %s\n", name);
+            fclose(f);
+            return -1;
+        }
+        if (vfc_scope_size == capacity) {
+            capacity = capacity ? 2 * capacity : 64;
+            vfc_scope_entries = realloc(vfc_scope_entries, capacity * sizeof(*vfc_scope_entries));
+            if (vfc_scope_entries == NULL) {
+                perror("Cannot allocate " VERIFICARLO_SCOPE " entries\n");
+                abort();
+            }
+        }
+        vfc_scope_entries[vfc_scope_size].name = strdup(name);
+        vfc_scope_entries[vfc_scope_size].precision = precision;
+        vfc_scope_size++;
+    }
+    fclose(f);
+
+    if (vfc_scope_size > 0xfffd) {
+        fprintf(stderr, VERIFICARLO_SCOPE " lists more than %d functions\n", 0xfffd);
+        return -1;
+    }
+    qsort(vfc_scope_entries, vfc_scope_size, sizeof(*vfc_scope_entries), vfc_scope_compare);
+    return 0;
+}
+
+/* Adds the functions of the scope defined by the object path loaded at
+ * base, from its symbol table or, if it is stripped, its dynamic one */
+static void vfc_scope_read_object(const char * path, uintptr_t base) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    int i, s;
+
+    if (fd < 0)
+        return;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(ElfW(Ehdr))) {
+        close(fd);
+        return;
+    }
+    const char * image = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED)
+        return;
+
+    const ElfW(Ehdr) * ehdr = (const ElfW(Ehdr) *) image;
+    const ElfW(Shdr) * shdr = (const ElfW(Shdr) *) (image + ehdr->e_shoff);
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0
+        || ehdr->e_shoff + ehdr->e_shnum * sizeof(ElfW(Shdr)) > (size_t) st.st_size) {
+        munmap((void *) image, st.st_size);
+        return;
+    }
+
+    int table = -1;
+    for (s = 0; s < ehdr->e_shnum; s++) {
+        if (shdr[s].sh_type == SHT_SYMTAB
+            || (shdr[s].sh_type == SHT_DYNSYM && table < 0))
+            table = s;
+    }
+
+    if (table >= 0 && shdr[table].sh_link < ehdr->e_shnum) {
+        const ElfW(Sym) * syms = (const ElfW(Sym) *) (image + shdr[table].sh_offset);
+        const char * strtab = image + shdr[shdr[table].sh_link].sh_offset;
+        int count = shdr[table].sh_size / sizeof(ElfW(Sym));
+
+        for (i = 0; i < count; i++) {
+            if (ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC
+                || syms[i].st_shndx == SHN_UNDEF || syms[i].st_size == 0)
+                continue;
+            struct vfc_scope_entry key = { (char *) strtab + syms[i].st_name, 0 };
+            struct vfc_scope_entry * e = bsearch(&key, vfc_scope_entries, vfc_scope_size,
+                                                 sizeof(key), vfc_scope_compare);
+            if (e == NULL)
+                continue;
+            vfc_scope_ranges = realloc(vfc_scope_ranges,
+                                       (vfc_scope_nranges + 1) * sizeof(*vfc_scope_ranges));
+            if (vfc_scope_ranges == NULL) {
+                perror("Cannot allocate " VERIFICARLO_SCOPE " functions\n");
+                abort();
+            }
+            vfc_scope_ranges[vfc_scope_nranges].start = base + syms[i].st_value;
+            vfc_scope_ranges[vfc_scope_nranges].end = base + syms[i].st_value + syms[i].st_size;
+            vfc_scope_ranges[vfc_scope_nranges].entry = e - vfc_scope_entries;
+            vfc_scope_nranges++;
+        }
+    }
+    munmap((void *) image, st.st_size);
+}
+
+/* Returns the scope entry of the function of a call site, -1 if it is
+ * out of the scope */
+static int vfc_scope_resolve(uintptr_t address) {
+    struct vfc_site_object o = { address, NULL, 0 };
+    int entry = -1, i;
+
+    pthread_mutex_lock(&vfc_scope_lock);
+    if (dl_iterate_phdr(vfc_site_object_find, &o) != 0) {
+        uintptr_t base = address - o.offset;
+        for (i = 0; i < vfc_scope_nobjects && vfc_scope_objects[i] != base; i++)
+            ;
+        if (i == vfc_scope_nobjects) {
+            vfc_scope_objects = realloc(vfc_scope_objects,
+                                        (vfc_scope_nobjects + 1) * sizeof(*vfc_scope_objects));
+            if (vfc_scope_objects == NULL) {
+                perror("Cannot allocate " VERIFICARLO_SCOPE " objects\n");
+                abort();
+            }
+            vfc_scope_objects[vfc_scope_nobjects++] = base;
+            vfc_scope_read_object(o.name[0] != '\0' ? o.name : "/proc/self/exe", base);
+        }
+    }
+    for (i = 0; i < vfc_scope_nranges; i++) {
+        if (address >= vfc_scope_ranges[i].start && address < vfc_scope_ranges[i].end) {
+            entry = vfc_scope_ranges[i].entry;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&vfc_scope_lock);
+    return entry;
+}
+
+/* Returns the scope entry of a call site, resolved on its first call */
+static inline int vfc_scope_lookup(uintptr_t address) {
+    uint32_t h = (uint32_t) ((address * UINT64_C(0x9e3779b97f4a7c15)) >> 40);
+    uint32_t i;
+
+    for (i = 0; i < VFC_SCOPE_SITES; i++) {
+        uint64_t v = __atomic_load_n(&vfc_scope_sites[(h + i) & (VFC_SCOPE_SITES - 1)],
+                                     __ATOMIC_ACQUIRE);
+        if (__builtin_expect((v >> 16) == address, 1))
+            return (int) (v & 0xffff) - 2;
+        if (v == 0)
+            break;
+    }
+
+    int entry = vfc_scope_resolve(address);
+    uint64_t packed = ((uint64_t) address << 16) | (uint64_t) (entry + 2);
+    if ((packed >> 16) != address)
+        return entry;
+    for (; i < VFC_SCOPE_SITES; i++) {
+        uint64_t expected = 0;
+        if (__atomic_compare_exchange_n(&vfc_scope_sites[(h + i) & (VFC_SCOPE_SITES - 1)],
+                                        &expected, packed, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+            || (expected >> 16) == address)
+            break;
+    }
+    return entry;
+}
+
+/* Rounds to nearest even on precision bits, the exponent range is kept */
+static inline double vfc_scope_double_round(double x, int precision) {
+    union { double d; uint64_t u; } hex = { .d = x };
+    if (precision == 0 || precision >= 53 || !isfinite(x))
+        return x;
+    int drop = 53 - precision;
+    hex.u += (UINT64_C(1) << (drop - 1)) - 1 + ((hex.u >> drop) & 1);
+    hex.u &= ~((UINT64_C(1) << drop) - 1);
+    return hex.d;
+}
+
+static inline float vfc_scope_float_round(float x, int precision) {
+    union { float f; uint32_t u; } hex = { .f = x };
+    if (precision == 0 || precision >= 24 || !isfinite(x))
+        return x;
+    int drop = 24 - precision;
+    hex.u += (UINT32_C(1) << (drop - 1)) - 1 + ((hex.u >> drop) & 1);
+    hex.u &= ~((UINT32_C(1) << drop) - 1);
+    return hex.f;
+}
+
+#define VFC_SCOPE_HOOK(type, op, operator)                                 \
+    static type vfc_scope_##type##op(type a, type b) {                     \
+        VFC_CALLER_ENTER();                                                \
+        int entry = vfc_scope_lookup(VFC_HOOK_SITE());                     \
+        type r = entry < 0 ? a operator b :                                \
+            vfc_scope_##type##_round(vfc_scope_next.type##op(a, b),        \
+                                     vfc_scope_entries[entry].precision);  \
+        VFC_CALLER_LEAVE();                                                \
+        return r;                                                          \
+    }
+
+VFC_SCOPE_HOOK(float, add, +)
+VFC_SCOPE_HOOK(float, sub, -)
+VFC_SCOPE_HOOK(float, mul, *)
+VFC_SCOPE_HOOK(float, div, /)
+VFC_SCOPE_HOOK(double, add, +)
+VFC_SCOPE_HOOK(double, sub, -)
+VFC_SCOPE_HOOK(double, mul, *)
+VFC_SCOPE_HOOK(double, div, /)
+
+/* Installs a configured backend vtable in _vfc_current_mca_interface,
+ * behind the profiling hooks when profiling is enabled. */
+static void vfc_install_interface(const struct mca_interface_t *iface) {
+    struct mca_interface_t hooks = *iface;
+
+    __atomic_store_n(&vfc_caller_recorded,
+                     vfc_cancel_file != NULL || vfc_scope_file != NULL
+                     || iface == vfc_backends[MCABACKEND_SHADOW].interface,
+                     __ATOMIC_RELAXED);
+
+    if (vfc_profile_file != NULL) {
+        hooks.floatadd = vfc_profile_floatadd;
+        hooks.floatsub = vfc_profile_floatsub;
+        hooks.floatmul = vfc_profile_floatmul;
+        hooks.floatdiv = vfc_profile_floatdiv;
+        hooks.doubleadd = vfc_profile_doubleadd;
+        hooks.doublesub = vfc_profile_doublesub;
+        hooks.doublemul = vfc_profile_doublemul;
+        hooks.doublediv = vfc_profile_doublediv;
+        /* vector operations go through the counted scalar entries */
+        hooks.floatadd_vector = NULL;
+        hooks.floatsub_vector = NULL;
+        hooks.floatmul_vector = NULL;
+        hooks.floatdiv_vector = NULL;
+        vfc_publish_interface(&vfc_profiled_interface, iface);
+    }
+
+    /* the cancellation hooks are called first, by the instrumented code */
+    if (vfc_cancel_file != NULL) {
+        vfc_publish_interface(&vfc_cancel_next, &hooks);
+        hooks.floatadd = vfc_cancel_floatadd;
+        hooks.floatsub = vfc_cancel_floatsub;
+        hooks.doubleadd = vfc_cancel_doubleadd;
+        hooks.doublesub = vfc_cancel_doublesub;
+        hooks.floatadd_vector = NULL;
+        hooks.floatsub_vector = NULL;
+        hooks.floatmul_vector = NULL;
+        hooks.floatdiv_vector = NULL;
+    }
+
+    /* the scope hooks are called first, they compute the operations out
+     * of the scope natively */
+    if (vfc_scope_file != NULL) {
+        vfc_publish_interface(&vfc_scope_next, &hooks);
+        hooks.floatadd = vfc_scope_floatadd;
+        hooks.floatsub = vfc_scope_floatsub;
+        hooks.floatmul = vfc_scope_floatmul;
+        hooks.floatdiv = vfc_scope_floatdiv;
+        hooks.doubleadd = vfc_scope_doubleadd;
+        hooks.doublesub = vfc_scope_doublesub;
+        hooks.doublemul = vfc_scope_doublemul;
+        hooks.doublediv = vfc_scope_doublediv;
+        hooks.floatadd_vector = NULL;
+        hooks.floatsub_vector = NULL;
+        hooks.floatmul_vector = NULL;
+        hooks.floatdiv_vector = NULL;
+    }
+
+    vfc_publish_interface(&_vfc_current_mca_interface, &hooks);
+}
+
+/* Configures a backend and makes it the current one */
+static void vfc_select_interface(struct mca_interface_t *iface) {
+    iface->set_mca_precision(verificarlo_precision);
+    iface->set_mca_mode(verificarlo_mcamode);
+    vfc_install_interface(iface);
+}
+
+/******************** AUTO BACKEND *****************************
+* AUTO computes each type with the fastest MCA backend valid at
+* the virtual precision. The noise of DD and QUAD is added to an
+* operation computed in a format of p bits, double for floats,
+* double-double or quad for doubles: the result is exact as long
+* as the virtual precision is at most about p / 2. MPFR computes
+* at the virtual precision and is valid for any precision.
+* In IEEE mode no noise is added and DD is always used, REF mode
+* is only implemented by MPFR.
+***************************************************************/
+
+/* AUTO candidates, fastest first, with the highest virtual precision at
+ * which they are valid for floats and doubles */
+static const struct {
+    int backend;
+    int float_precision;
+    int double_precision;
+} vfc_auto_candidates[] = {
+    { MCABACKEND_DD,   26, 53 },
+    { MCABACKEND_QUAD, 26, 56 },
+    { MCABACKEND_MPFR, INT_MAX, INT_MAX },
+};
+
+/* Returns 1 if the backend can be loaded */
+static int vfc_backend_available(int backend) {
+#ifdef VFC_STATIC_BACKENDS
+    return vfc_backends[backend].interface != NULL;
+#else
+    return 1;
+#endif
+}
+
+/* Returns the fastest available backend valid for a type at the given
+ * precision and mode. is_float selects floats or doubles. */
+static int vfc_auto_select(int is_float, unsigned int precision, int mode) {
+    int n = sizeof(vfc_auto_candidates) / sizeof(vfc_auto_candidates[0]);
+    int i;
+    if (mode == MCAMODE_REF)
+        return MCABACKEND_MPFR;
+    for (i = 0; i < n; i++) {
+        int max = is_float ? vfc_auto_candidates[i].float_precision
+                           : vfc_auto_candidates[i].double_precision;
+        if ((mode == MCAMODE_IEEE || precision <= (unsigned int) max)
+            && vfc_backend_available(vfc_auto_candidates[i].backend))
+            return vfc_auto_candidates[i].backend;
+    }
+    return MCABACKEND_MPFR;
+}
+
+/* Configures the backends selected for floats and doubles and makes their
+ * combination the current vtable. Returns 0 on success. */
+static int vfc_select_auto(void) {
+    static struct mca_interface_t hybrid;
+    int fb = vfc_auto_select(1, verificarlo_precision, verificarlo_mcamode);
+    int db = vfc_auto_select(0, verificarlo_precision, verificarlo_mcamode);
+
+    struct mca_interface_t * f = vfc_backend_get(fb);
+    struct mca_interface_t * d = vfc_backend_get(db);
+    if (f == NULL || d == NULL)
+        return -1;
+
+    f->set_mca_precision(verificarlo_precision);
+    f->set_mca_mode(verificarlo_mcamode);
+    if (d != f) {
+        d->set_mca_precision(verificarlo_precision);
+        d->set_mca_mode(verificarlo_mcamode);
+    }
+
+    /* set_mca_mode may have replaced the kernels: copy them afterwards */
+    hybrid = *d;
+    hybrid.floatadd = f->floatadd;
+    hybrid.floatsub = f->floatsub;
+    hybrid.floatmul = f->floatmul;
+    hybrid.floatdiv = f->floatdiv;
+    hybrid.floatadd_vector = f->floatadd_vector;
+    hybrid.floatsub_vector = f->floatsub_vector;
+    hybrid.floatmul_vector = f->floatmul_vector;
+    hybrid.floatdiv_vector = f->floatdiv_vector;
+    hybrid.floatdigits = f->floatdigits;
+
+    vfc_auto_float = fb;
+    vfc_auto_double = db;
+    vfc_install_interface(&hybrid);
+    return 0;
+}
+
+/* Parses a strictly positive integer. Returns -1 if invalid. */
+static int vfc_parse_uint(const char * value) {
+    char * endptr;
+    errno = 0;
+    long val = strtol(value, &endptr, 10);
+    if (errno != 0 || endptr == value || val <= 0 || val > 0x7fffffff)
+        return -1;
+    return val;
+}
+
+/* Parses a VERIFICARLO_MCAMODE value. Returns -1 if invalid. */
+static int vfc_parse_mode(const char * mode) {
+    int i;
+    for (i = 0; i < (int) (sizeof(vfc_mode_names) / sizeof(vfc_mode_names[0])); i++) {
+        if (strcmp(vfc_mode_names[i], mode) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/* Parses a VERIFICARLO_BACKEND value. Returns -1 if invalid. */
+static int vfc_parse_backend(const char * backend) {
+    int i;
+    for (i = 0; i < VFC_BACKENDS_COUNT; i++) {
+        if (vfc_backends[i].name != NULL && strcmp(vfc_backends[i].name, backend) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/* Parses an unsigned 64-bit integer. Returns -1 if invalid. */
+static int vfc_parse_uint64(const char * value, uint64_t * res) {
+    char * endptr;
+    errno = 0;
+    unsigned long long val = strtoull(value, &endptr, 0);
+    if (errno != 0 || endptr == value || *endptr != '\0' || value[0] == '-')
+        return -1;
+    *res = val;
+    return 0;
+}
+
+/* Parses a VERIFICARLO_RNG value. Returns -1 if invalid. */
+static int vfc_parse_rng(const char * rng) {
+    int i;
+    for (i = 0; i < (int) (sizeof(vfc_rng_names) / sizeof(vfc_rng_names[0])); i++) {
+        if (strcmp(vfc_rng_names[i], rng) == 0)
+            return i;
+    }
+    return -1;
+}
+
+/* Returns the rank of the process in an MPI job, 0 outside of MPI */
+static uint32_t vfc_mpi_rank(void) {
+    static const char * rank_variables[] = {
+        "OMPI_COMM_WORLD_RANK", "PMI_RANK", "PMIX_RANK", "MV2_COMM_WORLD_RANK"
+    };
+    int i;
+    for (i = 0; i < (int) (sizeof(rank_variables) / sizeof(rank_variables[0])); i++) {
+        char * rank = getenv(rank_variables[i]);
+        uint64_t val;
+        if (rank != NULL && vfc_parse_uint64(rank, &val) == 0)
+            return val;
+    }
+    return 0;
+}
+
+/* seeds all the loaded MCA backends. Without VERIFICARLO_SEED a new seed
+ * is drawn from the clock and the pid, otherwise the streams restart. */
 void vfc_seed(void) {
-    mpfr_mca_interface.seed();
-    quad_mca_interface.seed();
+    int i;
+
+    if (!vfc_seed_is_set) {
+        struct timeval t1;
+        gettimeofday(&t1, NULL);
+        vfc_rng_config.seed = ((uint64_t) t1.tv_sec * 1000000 + t1.tv_usec)
+            ^ ((uint64_t) getpid() << 40);
+    }
+
+    for (i = 0; i < VFC_BACKENDS_COUNT; i++) {
+        if (vfc_backends[i].initialized)
+            vfc_backends[i].interface->seed(&vfc_rng_config);
+    }
 }
 
-/* sets verificarlo precision and mode. Returns 0 on success. */
-int vfc_set_precision_and_mode(unsigned int precision, int mode) {
-	if (mode < 0 || mode > 3)
+/* assigns the id from which the random stream of the calling thread is
+ * derived */
+void vfc_rng_set_thread(int id) {
+    if (id < 0) {
+        fprintf(stderr, "vfc_rng_set_thread: invalid thread id %d\n", id);
+        return;
+    }
+    vfc_rng_thread_id = id;
+}
+
+/* must be called with vfc_config_lock held */
+static int vfc_apply_config(int backend, unsigned int precision, int mode) {
+	if (mode < 0 || mode > MCAMODE_REF)
 		return -1;
 
+    if (mode == MCAMODE_REF && backend != MCABACKEND_MPFR && backend != MCABACKEND_AUTO) {
+        fprintf(stderr, "REF mode is only available with the MPFR backend\n");
+        return -1;
+    }
+
+    /* a reference less precise than the doubles it checks is meaningless */
+    if (mode == MCAMODE_REF && precision < DOUBLE_PREC) {
+        fprintf(stderr, "REF mode requires a precision of at least %d bits\n", DOUBLE_PREC);
+        return -1;
+    }
+
+    /* AUTO selects its backends again for the new precision and mode */
+    if (backend == MCABACKEND_AUTO) {
+        int old_precision = verificarlo_precision;
+        int old_mode = verificarlo_mcamode;
+        verificarlo_precision = precision;
+        verificarlo_mcamode = mode;
+        if (vfc_select_auto() != 0) {
+            verificarlo_precision = old_precision;
+            verificarlo_mcamode = old_mode;
+            return -1;
+        }
+        verificarlo_backend = backend;
+        return 0;
+    }
+
+    /* Load the required backend */
+    struct mca_interface_t * iface = vfc_backend_get(backend);
+    if (iface == NULL)
+        return -1;
+
+    verificarlo_backend = backend;
     verificarlo_precision = precision;
     verificarlo_mcamode = mode;
 
-    /* Choose the required backend */
-    if (verificarlo_backend == MCABACKEND_MPFR) {
-      vfc_select_interface_mpfr();
+    vfc_select_interface(iface);
+    return 0;
+}
+
+/* sets verificarlo precision and mode. Returns 0 on success. */
+int vfc_set_precision_and_mode(unsigned int precision, int mode) {
+    pthread_mutex_lock(&vfc_config_lock);
+    int ret = vfc_apply_config(verificarlo_backend, precision, mode);
+    pthread_mutex_unlock(&vfc_config_lock);
+    return ret;
+}
+
+/* selects the MCA backend. Returns 0 on success. */
+int vfc_set_backend(int backend) {
+    pthread_mutex_lock(&vfc_config_lock);
+    int ret = vfc_apply_config(backend, verificarlo_precision, verificarlo_mcamode);
+    pthread_mutex_unlock(&vfc_config_lock);
+    return ret;
+}
+
+/* re-reads the control file and applies it. Returns 0 on success. */
+int vfc_reconfigure(void) {
+    if (vfc_control_file == NULL)
+        return -1;
+
+    FILE * f = fopen(vfc_control_file, "r");
+    if (f == NULL)
+        return -1;
+
+    pthread_mutex_lock(&vfc_config_lock);
+    int backend = verificarlo_backend;
+    int precision = verificarlo_precision;
+    int mode = verificarlo_mcamode;
+
+    /* The control file uses the same KEY=VALUE syntax as the environment,
+     * keys which are not present keep their current value */
+    char line[256];
+    while (fgets(line, sizeof(line), f) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char * value = strchr(line, '=');
+        if (line[0] == '#' || value == NULL)
+            continue;
+        *value++ = '\0';
+
+        int val;
+        if (strcmp(VERIFICARLO_PRECISION, line) == 0) {
+            val = vfc_parse_uint(value);
+            if (val > 0) precision = val;
+        } else if (strcmp(VERIFICARLO_MCAMODE, line) == 0) {
+            val = vfc_parse_mode(value);
+            if (val >= 0) mode = val;
+        } else if (strcmp(VERIFICARLO_BACKEND, line) == 0) {
+            val = vfc_parse_backend(value);
+            if (val >= 0) backend = val;
+        } else {
+            continue;
+        }
+        if (val < 0) {
+            fprintf(stderr, "%s invalid value provided in %s, ignoring\n",
+                    line, vfc_control_file);
+        }
+    }
+    fclose(f);
+
+    int ret = vfc_apply_config(backend, precision, mode);
+    pthread_mutex_unlock(&vfc_config_lock);
+    return ret;
+}
+
+/* Reconfiguration thread: polls the control file modification time and
+ * calls vfc_reconfigure when it changes. */
+static void * vfc_control_poll(void * arg) {
+    long period = *(long *) arg;
+    struct timespec delay = { period / 1000, (period % 1000) * 1000000 };
+    struct timespec last = { 0, 0 };
+    struct stat st;
+
+    if (stat(vfc_control_file, &st) == 0)
+        last = st.st_mtim;
+
+    for (;;) {
+        nanosleep(&delay, NULL);
+        if (stat(vfc_control_file, &st) != 0)
+            continue;
+        if (st.st_mtim.tv_sec == last.tv_sec && st.st_mtim.tv_nsec == last.tv_nsec)
+            continue;
+        last = st.st_mtim;
+        vfc_reconfigure();
+    }
+    return NULL;
+}
+
+/******************** PROBES ***********************************
+* vfc_probe values are accumulated per process with Welford's online
+* algorithm, directly in the process own row of a store mmapped from
+* VERIFICARLO_PROBE_FILE: concurrent samples never write to the same
+* location, and a sample that crashes or is killed keeps the values it
+* recorded. The row is claimed with an atomic increment on the first
+* probe and probe names are registered with a compare and swap: no
+* lock is shared between processes.
+* postprocess/vfc-probes.py merges the rows and reports the
+* significant digits of each probe.
+*
+* Store layout (native endianness):
+*   struct vfc_probe_header
+*   struct vfc_probe_name  names[max_probes]
+*   struct vfc_probe_stat  rows[max_samples][max_probes]
+***************************************************************/
+
+#define VFC_PROBE_MAGIC 0x45424f5250434656ULL /* "VFCPROBE" */
+#define VFC_PROBE_VERSION 1
+#define VFC_PROBE_NAME_SIZE 60
+
+/* probe name slot states */
+#define VFC_PROBE_FREE 0
+#define VFC_PROBE_WRITING 1
+#define VFC_PROBE_READY 2
+
+struct vfc_probe_header {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t max_probes;
+    uint32_t max_samples;
+    uint32_t samples; /* number of rows claimed */
+};
+
+struct vfc_probe_name {
+    uint32_t state;
+    char name[VFC_PROBE_NAME_SIZE];
+};
+
+struct vfc_probe_stat {
+    uint64_t count;
+    double mean;
+    double m2;
+};
+
+static struct vfc_probe_header * vfc_probe_store = NULL;
+static struct vfc_probe_stat * vfc_probe_local = NULL;
+static pthread_mutex_t vfc_probe_lock = PTHREAD_MUTEX_INITIALIZER;
+static int vfc_probe_disabled = 0;
+
+static struct vfc_probe_name * vfc_probe_names(struct vfc_probe_header * h) {
+    return (struct vfc_probe_name *) (h + 1);
+}
+
+static struct vfc_probe_stat * vfc_probe_row(struct vfc_probe_header * h, uint32_t row) {
+    struct vfc_probe_stat * rows = (struct vfc_probe_stat *) (vfc_probe_names(h) + h->max_probes);
+    return rows + (size_t) row * h->max_probes;
+}
+
+static size_t vfc_probe_store_size(uint32_t max_probes, uint32_t max_samples) {
+    return sizeof(struct vfc_probe_header)
+        + max_probes * sizeof(struct vfc_probe_name)
+        + (size_t) max_samples * max_probes * sizeof(struct vfc_probe_stat);
+}
+
+/* Returns the accumulators of this process: a row claimed in the store,
+ * or a private buffer, whose values are lost, when the store is full */
+static struct vfc_probe_stat * vfc_probe_claim(struct vfc_probe_header * h) {
+    uint32_t row = __atomic_fetch_add(&h->samples, 1, __ATOMIC_ACQ_REL);
+    if (row < h->max_samples)
+        return vfc_probe_row(h, row);
+
+    fprintf(stderr, "%s is full, increase " VERIFICARLO_PROBE_SAMPLES "\n",
+            getenv(VERIFICARLO_PROBE_FILE));
+    struct vfc_probe_stat * local = calloc(h->max_probes, sizeof(struct vfc_probe_stat));
+    if (local == NULL) {
+        perror("Cannot allocate probes\n");
+        abort();
+    }
+    return local;
+}
+
+/* A forked child is a new sample: it claims its own row */
+static void vfc_probe_atfork_child(void) {
+    if (vfc_probe_local != NULL)
+        vfc_probe_local = vfc_probe_claim(vfc_probe_store);
+}
+
+/* Maps the probe store, creating it if needed. Returns NULL on error. */
+static struct vfc_probe_header * vfc_probe_open(const char * path) {
+    uint32_t max_probes = VERIFICARLO_PROBE_MAX_DEFAULT;
+    uint32_t max_samples = VERIFICARLO_PROBE_SAMPLES_DEFAULT;
+    char * val;
+
+    if ((val = getenv(VERIFICARLO_PROBE_MAX)) != NULL && vfc_parse_uint(val) > 0)
+        max_probes = vfc_parse_uint(val);
+    if ((val = getenv(VERIFICARLO_PROBE_SAMPLES)) != NULL && vfc_parse_uint(val) > 0)
+        max_samples = vfc_parse_uint(val);
+
+    struct vfc_probe_header * h;
+    int fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd >= 0) {
+        /* We created the store: size and initialize it, the magic is
+         * published last so that other samples wait for the header */
+        size_t size = vfc_probe_store_size(max_probes, max_samples);
+        if (ftruncate(fd, size) != 0) {
+            close(fd);
+            return NULL;
+        }
+        h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (h == MAP_FAILED)
+            return NULL;
+        h->version = VFC_PROBE_VERSION;
+        h->max_probes = max_probes;
+        h->max_samples = max_samples;
+        __atomic_store_n(&h->magic, VFC_PROBE_MAGIC, __ATOMIC_RELEASE);
+        return h;
+    }
+
+    if (errno != EEXIST || (fd = open(path, O_RDWR)) < 0)
+        return NULL;
+
+    /* The store exists: wait until its creator has initialized it */
+    struct stat st;
+    int tries;
+    for (tries = 0; tries < 1000; tries++) {
+        if (fstat(fd, &st) == 0 && st.st_size >= (off_t) sizeof(*h))
+            break;
+        usleep(1000);
+    }
+    h = mmap(NULL, sizeof(*h), PROT_READ, MAP_SHARED, fd, 0);
+    if (h == MAP_FAILED) {
+        close(fd);
+        return NULL;
+    }
+    for (tries = 0; tries < 1000; tries++) {
+        if (__atomic_load_n(&h->magic, __ATOMIC_ACQUIRE) == VFC_PROBE_MAGIC)
+            break;
+        usleep(1000);
+    }
+    if (h->magic != VFC_PROBE_MAGIC || h->version != VFC_PROBE_VERSION) {
+        munmap(h, sizeof(*h));
+        close(fd);
+        return NULL;
+    }
+    size_t size = vfc_probe_store_size(h->max_probes, h->max_samples);
+    munmap(h, sizeof(*h));
+
+    h = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return h == MAP_FAILED ? NULL : h;
+}
+
+/* Returns the store slot of a probe, registering its name if needed.
+ * Returns -1 if the store is full. */
+static int vfc_probe_lookup(const char * name) {
+    struct vfc_probe_header * h = vfc_probe_store;
+    struct vfc_probe_name * names = vfc_probe_names(h);
+    uint32_t hash = 2166136261u;
+    const char * c;
+    uint32_t i;
+
+    for (c = name; *c; c++)
+        hash = (hash ^ (unsigned char) *c) * 16777619u;
+
+    /* open addressing with linear probing */
+    for (i = 0; i < h->max_probes; i++) {
+        uint32_t slot = (hash + i) % h->max_probes;
+        uint32_t state = __atomic_load_n(&names[slot].state, __ATOMIC_ACQUIRE);
+
+        if (state == VFC_PROBE_FREE) {
+            uint32_t expected = VFC_PROBE_FREE;
+            if (__atomic_compare_exchange_n(&names[slot].state, &expected,
+                                            VFC_PROBE_WRITING, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                strcpy(names[slot].name, name);
+                __atomic_store_n(&names[slot].state, VFC_PROBE_READY, __ATOMIC_RELEASE);
+                return slot;
+            }
+            state = expected;
+        }
+
+        /* another sample is registering this slot */
+        while (state == VFC_PROBE_WRITING)
+            state = __atomic_load_n(&names[slot].state, __ATOMIC_ACQUIRE);
+
+        if (strcmp(names[slot].name, name) == 0)
+            return slot;
     }
-    else if (verificarlo_backend == MCABACKEND_QUAD){
-      vfc_select_interface_quad();
+    return -1;
+}
+
+/* must be called with vfc_probe_lock held. Returns 0 if probes are enabled. */
+static int vfc_probe_init(void) {
+    if (vfc_probe_store != NULL)
+        return 0;
+    if (vfc_probe_disabled)
+        return -1;
+
+    char * path = getenv(VERIFICARLO_PROBE_FILE);
+    if (path == NULL) {
+        vfc_probe_disabled = 1;
+        return -1;
     }
-    else {
-    	perror("Invalid backend name in backend setting\n");
-	exit(-1);
+
+    vfc_probe_store = vfc_probe_open(path);
+    if (vfc_probe_store == NULL) {
+        fprintf(stderr, "Cannot open probe store %s\n", path);
+        vfc_probe_disabled = 1;
+        return -1;
     }
+    vfc_probe_local = vfc_probe_claim(vfc_probe_store);
+    pthread_atfork(NULL, NULL, vfc_probe_atfork_child);
     return 0;
 }
 
+/* must be called with vfc_probe_lock held */
+static void vfc_probe_record(const char * name, double value) {
+    /* a truncated name could merge two probes */
+    if (strlen(name) >= VFC_PROBE_NAME_SIZE) {
+        fprintf(stderr, "Probe name longer than %d characters, ignoring %s\n",
+                VFC_PROBE_NAME_SIZE - 1, name);
+        return;
+    }
+
+    int slot = vfc_probe_lookup(name);
+    if (slot < 0) {
+        fprintf(stderr, "Too many probes, increase " VERIFICARLO_PROBE_MAX
+                ", ignoring %s\n", name);
+        return;
+    }
+
+    /* Welford's online mean and variance */
+    struct vfc_probe_stat * p = &vfc_probe_local[slot];
+    p->count++;
+    double delta = value - p->mean;
+    p->mean += delta / p->count;
+    p->m2 += delta * (value - p->mean);
+}
+
+/* records the value of a named probe */
+void vfc_probe(const char * name, double value) {
+    pthread_mutex_lock(&vfc_probe_lock);
+    if (vfc_probe_init() == 0)
+        vfc_probe_record(name, value);
+    pthread_mutex_unlock(&vfc_probe_lock);
+}
+
+/* records n probes named name[0] ... name[n-1] */
+void vfc_probe_array(const char * name, const double * values, size_t n) {
+    /* room for the index, vfc_probe_record rejects the names too long */
+    char indexed[VFC_PROBE_NAME_SIZE + 24];
+    size_t i;
+
+    pthread_mutex_lock(&vfc_probe_lock);
+    if (vfc_probe_init() == 0) {
+        for (i = 0; i < n; i++) {
+            snprintf(indexed, sizeof(indexed), "%s[%zu]", name, i);
+            vfc_probe_record(indexed, values[i]);
+        }
+    }
+    pthread_mutex_unlock(&vfc_probe_lock);
+}
+
+/* returns the significant digits of x estimated by the current backend */
+double vfc_digits(double x) {
+    double (*digits)(double) =
+        __atomic_load_n(&_vfc_current_mca_interface.doubledigits, __ATOMIC_ACQUIRE);
+    return digits == NULL ? NAN : digits(x);
+}
+
+double vfc_digitsf(float x) {
+    double (*digits)(float) =
+        __atomic_load_n(&_vfc_current_mca_interface.floatdigits, __ATOMIC_ACQUIRE);
+    return digits == NULL ? NAN : digits(x);
+}
+
 /* vfc_init is run when loading vfcwrapper and initializes vfc libraries */
 __attribute__((constructor(0)))
 static void vfc_init (void)
 {
-    char * endptr;
-
     /* If VERIFICARLO_PRECISION is set, try to parse it */
     char * precision = getenv(VERIFICARLO_PRECISION);
     if (precision != NULL) {
-        errno = 0;
-        int val = strtol(precision, &endptr, 10);
-        if (errno != 0 || val <= 0) {
+        int val = vfc_parse_uint(precision);
+        if (val < 0) {
             /* Invalid value provided */
             fprintf(stderr, VERIFICARLO_PRECISION
                    " invalid value provided, defaulting to default\n");
@@ -115,82 +1762,205 @@ static void vfc_init (void)
      /* If VERIFICARLO_MCAMODE is set, try to parse it */
     char * mode = getenv(VERIFICARLO_MCAMODE);
     if (mode != NULL) {
-        if (strcmp("IEEE", mode) == 0) {
-            verificarlo_mcamode = MCAMODE_IEEE;
-        }
-        else if (strcmp("MCA", mode) == 0) {
-            verificarlo_mcamode = MCAMODE_MCA;
-        }
-        else if (strcmp("PB", mode) == 0) {
-            verificarlo_mcamode = MCAMODE_PB;
-        }
-        else if (strcmp("RR", mode) == 0) {
-            verificarlo_mcamode = MCAMODE_RR;
-        } else {
+        int val = vfc_parse_mode(mode);
+        if (val < 0) {
             /* Invalid value provided */
             fprintf(stderr, VERIFICARLO_MCAMODE
                    " invalid value provided, defaulting to default\n");
+        } else {
+            verificarlo_mcamode = val;
         }
     }
 
     /* If VERIFICARLO_BACKEND is set, try to parse it */
     char * backend = getenv(VERIFICARLO_BACKEND);
     if (backend != NULL) {
-      if (strcmp("QUAD", backend) == 0) {
-        verificarlo_backend = MCABACKEND_QUAD;
-      }
-      else if (strcmp("MPFR", backend) == 0) {
-        verificarlo_backend = MCABACKEND_MPFR;
-      }else {
+      int val = vfc_parse_backend(backend);
+      if (val < 0) {
         /* Invalid value provided */
         fprintf(stderr, VERIFICARLO_BACKEND
                 " invalid value provided, defaulting to default\n");
+      } else {
+        verificarlo_backend = val;
       }
+    } else if (getenv(VERIFICARLO_BACKEND_PLUGIN) != NULL) {
+      /* a plugin given without a backend is selected */
+      verificarlo_backend = MCABACKEND_PLUGIN;
+    }
+
+    /* If VERIFICARLO_SEED is set, samples are reproducible */
+    char * seed = getenv(VERIFICARLO_SEED);
+    if (seed != NULL) {
+        if (vfc_parse_uint64(seed, &vfc_rng_config.seed) != 0) {
+            fprintf(stderr, VERIFICARLO_SEED
+                    " invalid value provided, defaulting to default\n");
+        } else {
+            vfc_seed_is_set = 1;
+        }
     }
 
-    /* seed the backends */
+    char * sample = getenv(VERIFICARLO_SAMPLE);
+    if (sample != NULL && vfc_parse_uint64(sample, &vfc_rng_config.sample) != 0) {
+        fprintf(stderr, VERIFICARLO_SAMPLE
+                " invalid value provided, defaulting to default\n");
+        vfc_rng_config.sample = 0;
+    }
+
+    char * rng = getenv(VERIFICARLO_RNG);
+    if (rng != NULL) {
+        int val = vfc_parse_rng(rng);
+        if (val < 0) {
+            fprintf(stderr, VERIFICARLO_RNG
+                    " invalid value provided, defaulting to default\n");
+        } else {
+            vfc_rng_config.generator = val;
+        }
+    }
+
+    /* Random values are generated in blocks of VERIFICARLO_RNG_BUFFER */
+    char * buffer = getenv(VERIFICARLO_RNG_BUFFER);
+    if (buffer != NULL) {
+        int val = vfc_parse_uint(buffer);
+        if (val < 0 || val > VFC_RNG_BUFFER_MAX) {
+            fprintf(stderr, VERIFICARLO_RNG_BUFFER
+                    " invalid value provided, must be between 1 and %d,"
+                    " defaulting to default\n", VFC_RNG_BUFFER_MAX);
+        } else {
+            vfc_rng_config.buffer = val;
+        }
+    }
+
+    vfc_rng_config.rank = vfc_mpi_rank();
+
+    /* draws the seed if needed, backends are seeded when loaded */
     vfc_seed();
 
-    /* set precision and mode */
-    vfc_set_precision_and_mode(verificarlo_precision, verificarlo_mcamode);
+    /* If VERIFICARLO_PROFILE is set, install the profiling hooks */
+    vfc_profile_file = getenv(VERIFICARLO_PROFILE);
+    if (vfc_profile_file != NULL) {
+        char * period = getenv(VERIFICARLO_PROFILE_PERIOD);
+        if (period != NULL) {
+            int val = vfc_parse_uint(period);
+            if (val < 0) {
+                fprintf(stderr, VERIFICARLO_PROFILE_PERIOD
+                        " invalid value provided, defaulting to default\n");
+            } else {
+                vfc_profile_period = val;
+            }
+        }
+        atexit(vfc_profile_report);
+    }
+
+    /* If VERIFICARLO_SCOPE is set, restrict the backend to its functions */
+    vfc_scope_file = getenv(VERIFICARLO_SCOPE);
+    if (vfc_scope_file != NULL && vfc_scope_parse(vfc_scope_file) != 0)
+        exit(-1);
+
+    /* If VERIFICARLO_CANCELLATION is set, install the cancellation hooks */
+    vfc_cancel_file = getenv(VERIFICARLO_CANCELLATION);
+    if (vfc_cancel_file != NULL && vfc_scope_file != NULL) {
+        fprintf(stderr, VERIFICARLO_CANCELLATION " is ignored with " VERIFICARLO_SCOPE "\n");
+        vfc_cancel_file = NULL;
+    }
+    if (vfc_cancel_file != NULL) {
+        char * threshold = getenv(VERIFICARLO_CANCELLATION_THRESHOLD);
+        if (threshold != NULL) {
+            int val = vfc_parse_uint(threshold);
+            if (val < 0 || val >= VFC_CANCEL_BUCKETS) {
+                fprintf(stderr, VERIFICARLO_CANCELLATION_THRESHOLD
+                        " invalid value provided, must be between 1 and %d,"
+                        " defaulting to default\n", VFC_CANCEL_BUCKETS - 1);
+            } else {
+                vfc_cancel_threshold = val;
+            }
+        }
+        atexit(vfc_cancel_report);
+    }
+
+    /* load and seed the backend, set precision and mode */
+    if (vfc_set_precision_and_mode(verificarlo_precision, verificarlo_mcamode) != 0) {
+        fprintf(stderr, "Cannot initialize %s backend\n",
+                vfc_backends[verificarlo_backend].name);
+        exit(-1);
+    }
+
+    /* If VERIFICARLO_CONTROL_FILE is set, apply it and start polling it */
+    vfc_control_file = getenv(VERIFICARLO_CONTROL_FILE);
+    if (vfc_control_file != NULL) {
+        static long period = VERIFICARLO_CONTROL_POLL_DEFAULT;
+        char * poll = getenv(VERIFICARLO_CONTROL_POLL);
+        if (poll != NULL) {
+            int val = vfc_parse_uint(poll);
+            if (val < 0) {
+                fprintf(stderr, VERIFICARLO_CONTROL_POLL
+                        " invalid value provided, defaulting to default\n");
+            } else {
+                period = val;
+            }
+        }
+
+        vfc_reconfigure();
+
+        pthread_t poller;
+        if (pthread_create(&poller, NULL, vfc_control_poll, &period) != 0) {
+            perror("Cannot start " VERIFICARLO_CONTROL_FILE " polling thread\n");
+        } else {
+            pthread_detach(poller);
+        }
+    }
 }
 
 typedef double double2 __attribute__((ext_vector_type(2)));
 typedef double double4 __attribute__((ext_vector_type(4)));
 typedef float float2 __attribute__((ext_vector_type(2)));
 typedef float float4 __attribute__((ext_vector_type(4)));
+typedef double double8 __attribute__((ext_vector_type(8)));
+typedef double double16 __attribute__((ext_vector_type(16)));
+typedef float float8 __attribute__((ext_vector_type(8)));
+typedef float float16 __attribute__((ext_vector_type(16)));
 
 /* Arithmetic vector wrappers */
 
+/* the elements of a vector operation are attributed to the caller of the
+ * wrapper, see VFC_CALLER_ENTER */
+
 double2 _2xdoubleadd(double2 a, double2 b) {
     double2 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doubleadd(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doubleadd(a[1],b[1]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
 double2 _2xdoublesub(double2 a, double2 b) {
     double2 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doublesub(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doublesub(a[1],b[1]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
 double2 _2xdoublemul(double2 a, double2 b) {
     double2 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doublemul(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doublemul(a[1],b[1]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
 double2 _2xdoublediv(double2 a, double2 b) {
     double2 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doublediv(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doublediv(a[1],b[1]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
@@ -200,40 +1970,48 @@ double2 _2xdoublediv(double2 a, double2 b) {
 double4 _4xdoubleadd(double4 a, double4 b) {
     double4 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doubleadd(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doubleadd(a[1],b[1]);
     c[2] = _vfc_current_mca_interface.doubleadd(a[2],b[2]);
     c[3] = _vfc_current_mca_interface.doubleadd(a[3],b[3]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
 double4 _4xdoublesub(double4 a, double4 b) {
     double4 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doublesub(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doublesub(a[1],b[1]);
     c[2] = _vfc_current_mca_interface.doublesub(a[2],b[2]);
     c[3] = _vfc_current_mca_interface.doublesub(a[3],b[3]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
 double4 _4xdoublemul(double4 a, double4 b) {
     double4 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doublemul(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doublemul(a[1],b[1]);
     c[2] = _vfc_current_mca_interface.doublemul(a[2],b[2]);
     c[3] = _vfc_current_mca_interface.doublemul(a[3],b[3]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
 double4 _4xdoublediv(double4 a, double4 b) {
     double4 c;
 
+    VFC_CALLER_ENTER();
     c[0] = _vfc_current_mca_interface.doublediv(a[0],b[0]);
     c[1] = _vfc_current_mca_interface.doublediv(a[1],b[1]);
     c[2] = _vfc_current_mca_interface.doublediv(a[2],b[2]);
     c[3] = _vfc_current_mca_interface.doublediv(a[3],b[3]);
+    VFC_CALLER_LEAVE();
     return c;
 }
 
@@ -241,75 +2019,69 @@ double4 _4xdoublediv(double4 a, double4 b) {
 /*********************************************************/
 
 
-float2 _2xfloatadd(float2 a, float2 b) {
-    float2 c;
-
-    c[0] = _vfc_current_mca_interface.floatadd(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatadd(a[1],b[1]);
-    return c;
-}
-
-float2 _2xfloatsub(float2 a, float2 b) {
-    float2 c;
-
-    c[0] = _vfc_current_mca_interface.floatsub(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatsub(a[1],b[1]);
-    return c;
-}
-
-float2 _2xfloatmul(float2 a, float2 b) {
-    float2 c;
-
-    c[0] = _vfc_current_mca_interface.floatmul(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatmul(a[1],b[1]);
-    return c;
-}
-
-float2 _2xfloatdiv(float2 a, float2 b) {
-    float2 c;
-
-    c[0] = _vfc_current_mca_interface.floatdiv(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatdiv(a[1],b[1]);
-    return c;
-}
+/* Float vectors are computed by the vector entry of the backend when it
+ * has one, lane by lane through the scalar entry otherwise */
+#define VFC_FLOAT_VECTOR_WRAPPER(size, op)                                  \
+    float##size _##size##xfloat##op(float##size a, float##size b) {         \
+        float##size c;                                                      \
+        void (*vector)(int, float *, const float *, const float *) =        \
+            _vfc_current_mca_interface.float##op##_vector;                  \
+        int i;                                                              \
+                                                                            \
+        if (vector != NULL) {                                               \
+            vector(size, (float *) &c, (const float *) &a,                  \
+                   (const float *) &b);                                     \
+            return c;                                                       \
+        }                                                                   \
+        VFC_CALLER_ENTER();                                                 \
+        for (i = 0; i < size; i++)                                          \
+            c[i] = _vfc_current_mca_interface.float##op(a[i], b[i]);        \
+        VFC_CALLER_LEAVE();                                                 \
+        return c;                                                           \
+    }
 
-float4 _4xfloatadd(float4 a, float4 b) {
-    float4 c;
+VFC_FLOAT_VECTOR_WRAPPER(2, add)
+VFC_FLOAT_VECTOR_WRAPPER(2, sub)
+VFC_FLOAT_VECTOR_WRAPPER(2, mul)
+VFC_FLOAT_VECTOR_WRAPPER(2, div)
 
-    c[0] = _vfc_current_mca_interface.floatadd(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatadd(a[1],b[1]);
-    c[2] = _vfc_current_mca_interface.floatadd(a[2],b[2]);
-    c[3] = _vfc_current_mca_interface.floatadd(a[3],b[3]);
-    return c;
-}
+VFC_FLOAT_VECTOR_WRAPPER(4, add)
+VFC_FLOAT_VECTOR_WRAPPER(4, sub)
+VFC_FLOAT_VECTOR_WRAPPER(4, mul)
+VFC_FLOAT_VECTOR_WRAPPER(4, div)
 
-float4 _4xfloatsub(float4 a, float4 b) {
-    float4 c;
+VFC_FLOAT_VECTOR_WRAPPER(8, add)
+VFC_FLOAT_VECTOR_WRAPPER(8, sub)
+VFC_FLOAT_VECTOR_WRAPPER(8, mul)
+VFC_FLOAT_VECTOR_WRAPPER(8, div)
 
-    c[0] = _vfc_current_mca_interface.floatsub(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatsub(a[1],b[1]);
-    c[2] = _vfc_current_mca_interface.floatsub(a[2],b[2]);
-    c[3] = _vfc_current_mca_interface.floatsub(a[3],b[3]);
-    return c;
-}
+VFC_FLOAT_VECTOR_WRAPPER(16, add)
+VFC_FLOAT_VECTOR_WRAPPER(16, sub)
+VFC_FLOAT_VECTOR_WRAPPER(16, mul)
+VFC_FLOAT_VECTOR_WRAPPER(16, div)
 
-float4 _4xfloatmul(float4 a, float4 b) {
-    float4 c;
+/*********************************************************/
 
-    c[0] = _vfc_current_mca_interface.floatmul(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatmul(a[1],b[1]);
-    c[2] = _vfc_current_mca_interface.floatmul(a[2],b[2]);
-    c[3] = _vfc_current_mca_interface.floatmul(a[3],b[3]);
-    return c;
-}
+/* Wider double vectors are computed lane by lane */
+#define VFC_DOUBLE_VECTOR_WRAPPER(size, op)                                 \
+    double##size _##size##xdouble##op(double##size a, double##size b) {     \
+        double##size c;                                                     \
+        int i;                                                              \
+                                                                            \
+        VFC_CALLER_ENTER();                                                 \
+        for (i = 0; i < size; i++)                                          \
+            c[i] = _vfc_current_mca_interface.double##op(a[i], b[i]);       \
+        VFC_CALLER_LEAVE();                                                 \
+        return c;                                                           \
+    }
 
-float4 _4xfloatdiv(float4 a, float4 b) {
-    float4 c;
+VFC_DOUBLE_VECTOR_WRAPPER(8, add)
+VFC_DOUBLE_VECTOR_WRAPPER(8, sub)
+VFC_DOUBLE_VECTOR_WRAPPER(8, mul)
+VFC_DOUBLE_VECTOR_WRAPPER(8, div)
 
-    c[0] = _vfc_current_mca_interface.floatdiv(a[0],b[0]);
-    c[1] = _vfc_current_mca_interface.floatdiv(a[1],b[1]);
-    c[2] = _vfc_current_mca_interface.floatdiv(a[2],b[2]);
-    c[3] = _vfc_current_mca_interface.floatdiv(a[3],b[3]);
-    return c;
-}
+VFC_DOUBLE_VECTOR_WRAPPER(16, add)
+VFC_DOUBLE_VECTOR_WRAPPER(16, sub)
+VFC_DOUBLE_VECTOR_WRAPPER(16, mul)
+VFC_DOUBLE_VECTOR_WRAPPER(16, div)
 
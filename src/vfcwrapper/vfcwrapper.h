@@ -21,22 +21,99 @@
  *                                                                              *
  ********************************************************************************/
 
+#ifndef VFCWRAPPER_H
+#define VFCWRAPPER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
 /* define the available MCA modes of operation */
 #define MCAMODE_IEEE 0
 #define MCAMODE_MCA  1
 #define MCAMODE_PB   2
 #define MCAMODE_RR   3
+#define MCAMODE_REF  4 /* MPFR only: reference run at the virtual precision */
 
 /* define the available MCA backends */
 #define MCABACKEND_QUAD 0
 #define MCABACKEND_MPFR 1
 #define MCABACKEND_RDROUND 2
-/* seeds all the MCA backends */
+#define MCABACKEND_DD 3
+#define MCABACKEND_VPREC 4
+#define MCABACKEND_CESTAC 5
+#define MCABACKEND_AUTO 6
+#define MCABACKEND_PLUGIN 7
+#define MCABACKEND_SHADOW 8
+
+/* define the available random generators */
+#define VFC_RNG_TINYMT 0
+#define VFC_RNG_PHILOX 1
+#define VFC_RNG_XOSHIRO 2
+
+/* maximum number of random values generated per refill of a thread buffer */
+#define VFC_RNG_BUFFER_MAX 1024
+
+/* configuration passed to the backends seed function. Each thread of
+ * each sample draws from its own random stream derived from
+ * (seed, sample, thread, rank). */
+struct vfc_rng_config_t {
+    uint64_t seed;   /* VERIFICARLO_SEED, or drawn from the clock and pid */
+    uint64_t sample; /* VERIFICARLO_SAMPLE */
+    uint32_t rank;   /* MPI rank, 0 outside of MPI */
+    int generator;   /* VERIFICARLO_RNG */
+    uint32_t buffer; /* VERIFICARLO_RNG_BUFFER, values generated per refill */
+    int (*thread)(void); /* id of the calling thread given to
+                          * vfc_rng_set_thread, or -1 */
+    uintptr_t (*caller)(void); /* call site of the instrumented operation
+                                * when a vector wrapper or hook calls the
+                                * backend, 0 when the instrumented code
+                                * calls it directly. Only recorded for
+                                * the SHADOW backend. */
+};
+
+/* assigns the id of the calling thread, in [0, 2^31), from which its
+ * random stream is derived. Must be called before the first instrumented
+ * operation of the thread. Threads without an id are numbered in the order
+ * of their first random draw, which depends on the scheduling: assign ids
+ * to replay a multithreaded sample from its seed and sample. */
+void vfc_rng_set_thread(int id);
+/* seeds all the loaded MCA backends */
 void vfc_seed(void);
 
-/* sets verificarlo precision and mode. Returns 0 on success. */
+/* sets verificarlo precision and mode. Returns 0 on success.
+ * The configuration functions may be called while other threads compute:
+ * each operation runs entirely with either the previous or the new
+ * precision and mode, never with the precision of one and the mode of the
+ * other, and the operations started after the call returns use the new
+ * configuration. */
 int vfc_set_precision_and_mode(unsigned int precision, int mode);
 
+/* selects the MCA backend. Returns 0 on success. */
+int vfc_set_backend(int backend);
+
+/* re-reads the file given by VERIFICARLO_CONTROL_FILE and applies the
+ * precision, mode and backend it contains. Returns 0 on success. */
+int vfc_reconfigure(void);
+
+/* records the value of a named probe in the store given by
+ * VERIFICARLO_PROBE_FILE. The store accumulates the mean and variance of
+ * each probe over all the samples (processes) sharing it. The values are
+ * written to the store as they are recorded, a sample that crashes keeps
+ * the probes it recorded. Names are at most 59 characters long, longer
+ * names are ignored with a warning. Does nothing when
+ * VERIFICARLO_PROBE_FILE is not set. */
+void vfc_probe(const char * name, double value);
+
+/* records n probes named name[0] ... name[n-1] */
+void vfc_probe_array(const char * name, const double * values, size_t n);
+
+/* returns the number of significant decimal digits of x estimated by the
+ * current backend, or NAN if the backend does not estimate them (only
+ * CESTAC and SHADOW do). x must be the value returned by an instrumented
+ * operation, or a copy of it. */
+double vfc_digits(double x);
+double vfc_digitsf(float x);
+
 /* MCA backend interface */
 struct mca_interface_t {
     float (*floatadd)(float, float);
@@ -49,7 +126,90 @@ struct mca_interface_t {
     double (*doublemul)(double, double);
     double (*doublediv)(double, double);
 
-    void (*seed)(void);
+    void (*seed)(const struct vfc_rng_config_t *);
+    /* The runtime calls set_mca_precision then set_mca_mode, and only
+     * then copies the kernels. Kernels of the previous configuration may
+     * still be running in other threads: a backend publishes the new
+     * precision in set_mca_mode, together with the mode, so that no
+     * kernel reads the precision set for another mode. */
     int (*set_mca_mode)(int);
     int (*set_mca_precision)(int);
+
+    /* Optional vector entries, NULL when the backend has none: they
+     * compute c[i] = a[i] op b[i] for i < n as n calls to the scalar
+     * entry would. The vector wrappers fall back to the scalar entries. */
+    void (*floatadd_vector)(int n, float *c, const float *a, const float *b);
+    void (*floatsub_vector)(int n, float *c, const float *a, const float *b);
+    void (*floatmul_vector)(int n, float *c, const float *a, const float *b);
+    void (*floatdiv_vector)(int n, float *c, const float *a, const float *b);
+
+    /* Optional significant digits estimates, NULL when the backend has
+     * none: see vfc_digits. */
+    double (*floatdigits)(float);
+    double (*doubledigits)(double);
 };
+
+/* External backend plugins.
+ *
+ * VERIFICARLO_BACKEND=PLUGIN loads a backend built out of tree from the
+ * shared library given by VERIFICARLO_BACKEND_PLUGIN. The library exports
+ * a struct vfc_plugin_t named vfc_plugin. Its size and version fields let
+ * the runtime check the layout it was built with: version is only bumped
+ * for incompatible changes, new entries are appended at the end of the
+ * structure and are ignored when the plugin structure is too small to hold
+ * them. Optional entries are only called when the plugin advertises their
+ * capability, the runtime falls back to the scalar entries otherwise.
+ *
+ * The entries are read again each time the mode or precision is set: like
+ * the in-tree backends, a plugin may switch its kernels in set_mca_mode. */
+#define VFC_PLUGIN_VERSION 1
+#define VFC_PLUGIN_SYMBOL "vfc_plugin"
+
+/* plugin capabilities */
+#define VFC_PLUGIN_CAP_VECTOR (1u << 0) /* float*_vector entries */
+#define VFC_PLUGIN_CAP_DIGITS (1u << 1) /* floatdigits and doubledigits */
+/* reserved for batched, fused multiply-add and math function entries,
+ * which the instrumentation does not emit yet */
+#define VFC_PLUGIN_CAP_BATCH  (1u << 2)
+#define VFC_PLUGIN_CAP_FMA    (1u << 3)
+#define VFC_PLUGIN_CAP_MATH   (1u << 4)
+
+struct vfc_plugin_t {
+    uint32_t size;    /* sizeof(struct vfc_plugin_t) in the plugin */
+    uint32_t version; /* VFC_PLUGIN_VERSION */
+    uint32_t caps;    /* VFC_PLUGIN_CAP_* */
+    const char * name;
+
+    /* Optional lifecycle: init is called once when the library is
+     * loaded, before the other entries, and returns 0 on success;
+     * teardown is called at exit. */
+    int (*init)(void);
+    void (*teardown)(void);
+
+    /* mandatory entries, see mca_interface_t */
+    void (*seed)(const struct vfc_rng_config_t *);
+    int (*set_mca_mode)(int);
+    int (*set_mca_precision)(int);
+
+    float (*floatadd)(float, float);
+    float (*floatsub)(float, float);
+    float (*floatmul)(float, float);
+    float (*floatdiv)(float, float);
+
+    double (*doubleadd)(double, double);
+    double (*doublesub)(double, double);
+    double (*doublemul)(double, double);
+    double (*doublediv)(double, double);
+
+    /* VFC_PLUGIN_CAP_VECTOR */
+    void (*floatadd_vector)(int n, float *c, const float *a, const float *b);
+    void (*floatsub_vector)(int n, float *c, const float *a, const float *b);
+    void (*floatmul_vector)(int n, float *c, const float *a, const float *b);
+    void (*floatdiv_vector)(int n, float *c, const float *a, const float *b);
+
+    /* VFC_PLUGIN_CAP_DIGITS */
+    double (*floatdigits)(float);
+    double (*doubledigits)(double);
+};
+
+#endif
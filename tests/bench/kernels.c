@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define N 2000000
+
+/* One instrumented operation per iteration */
+#define KERNEL(name, type, op)                          \
+    type name(type s, type x, int n) {                  \
+        int i;                                          \
+        for (i = 0; i < n; i++)                         \
+            s = s op x;                                 \
+        return s;                                       \
+    }
+
+KERNEL(floatadd, float, +)
+KERNEL(floatsub, float, -)
+KERNEL(floatmul, float, *)
+KERNEL(floatdiv, float, /)
+KERNEL(doubleadd, double, +)
+KERNEL(doublesub, double, -)
+KERNEL(doublemul, double, *)
+KERNEL(doublediv, double, /)
+
+static long long now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+#define BENCH(name, x) {                                        \
+        long long start = now();                                \
+        volatile double r = name(1, x, N);                      \
+        printf(" %s %.1f", #name, (double) (now() - start) / N); \
+    }
+
+int main(void) {
+    BENCH(floatadd, 1e-3f);
+    BENCH(floatsub, 1e-3f);
+    BENCH(floatmul, 1.0000001f);
+    BENCH(floatdiv, 1.0000001f);
+    BENCH(doubleadd, 1e-3);
+    BENCH(doublesub, 1e-3);
+    BENCH(doublemul, 1.0000001);
+    BENCH(doublediv, 1.0000001);
+    printf("\n");
+    return 0;
+}
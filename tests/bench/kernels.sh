@@ -0,0 +1,20 @@
+#!/bin/bash
+# Measures the cost in ns of each instrumented operation, per backend
+# and mode, and per virtual precision for MPFR. Run it against two
+# verificarlo installations to compare them.
+set -e
+
+for f in floatadd floatsub floatmul floatdiv doubleadd doublesub doublemul doublediv; do
+    echo $f
+done > kernels_functions
+verificarlo -O2 kernels.c -o kernels --functions-file=kernels_functions
+
+for backend in QUAD DD MPFR; do
+    for mode in IEEE MCA PB RR; do
+        echo "$backend $mode:$(VERIFICARLO_BACKEND=$backend VERIFICARLO_MCAMODE=$mode ./kernels)"
+    done
+done
+
+for precision in 24 53 113; do
+    echo "MPFR MCA $precision:$(VERIFICARLO_BACKEND=MPFR VERIFICARLO_PRECISION=$precision ./kernels)"
+done
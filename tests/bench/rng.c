@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "common/vfc_rng.h"
+
+#define N 20000000
+#define BLOCK 256
+
+static long long now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+static uint64_t block[BLOCK];
+
+/* Cost of filling blocks of BLOCK values with each generator */
+static void bench_fill(void) {
+    tinymt64_t tinymt;
+    philox4x32_t philox;
+    xoshiro256_t xoshiro;
+    uint64_t seed[4] = { 1, 2, 3, 4 };
+    long long start;
+    int i, j;
+
+    tinymt64_init(&tinymt, 42);
+    start = now();
+    for (i = 0; i < N; i += BLOCK)
+        for (j = 0; j < BLOCK; j++)
+            block[j] = tinymt64_generate_uint64(&tinymt);
+    printf("fill TINYMT %.2f ns\n", (double) (now() - start) / N);
+
+    philox4x32_init(&philox, 42, 0);
+    start = now();
+    for (i = 0; i < N; i += BLOCK)
+        philox4x32_generate_uint64_array(&philox, block, BLOCK);
+    printf("fill PHILOX %.2f ns\n", (double) (now() - start) / N);
+
+    xoshiro256_init(&xoshiro, seed);
+    start = now();
+    for (i = 0; i < N; i += BLOCK)
+        xoshiro256_generate_uint64_array(&xoshiro, block, BLOCK);
+    printf("fill XOSHIRO %.2f ns\n", (double) (now() - start) / N);
+}
+
+/* Cost of a draw from the thread buffer, refills included */
+static void bench_draw(int generator) {
+    static const char * names[] = { "TINYMT", "PHILOX", "XOSHIRO" };
+    struct vfc_rng_config_t config = { 42, 0, 0, generator, BLOCK };
+    volatile uint64_t sink = 0;
+    long long start;
+    int i;
+
+    vfc_rng_seed(&config, MCABACKEND_QUAD);
+    start = now();
+    for (i = 0; i < N; i++)
+        sink += vfc_rng_uint64();
+    printf("draw %s %.2f ns\n", names[generator], (double) (now() - start) / N);
+}
+
+int main(void) {
+    bench_fill();
+    bench_draw(VFC_RNG_TINYMT);
+    bench_draw(VFC_RNG_PHILOX);
+    bench_draw(VFC_RNG_XOSHIRO);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#include <stdio.h>
+
+double f(double a, double b) {
+    return a + b;
+}
+
+int main(void) {
+    printf("%g\n", f(0.1, 0.2));
+    return 0;
+}
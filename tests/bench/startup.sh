@@ -0,0 +1,31 @@
+#!/bin/bash
+# Measures binary size and startup time of an instrumented program.
+# Run it against two verificarlo installations to compare them.
+set -e
+
+RUNS=${RUNS:-200}
+
+startup() {
+    local start=$(date +%s%N)
+    for i in $(seq $RUNS); do
+        ./$1 > /dev/null
+    done
+    local end=$(date +%s%N)
+    echo "$(( (end - start) / RUNS / 1000 )) us"
+}
+
+verificarlo -O2 startup.c -o startup_dynamic
+verificarlo -O2 -static startup.c -o startup_static
+verificarlo -O2 -static --static-backends=QUAD startup.c -o startup_static_quad
+
+for bin in startup_dynamic startup_static startup_static_quad; do
+    echo "$bin size: $(stat -c %s $bin) bytes"
+done
+
+for backend in QUAD MPFR; do
+    export VERIFICARLO_BACKEND=$backend
+    echo "startup_dynamic $backend: $(startup startup_dynamic)"
+    echo "startup_static $backend: $(startup startup_static)"
+done
+export VERIFICARLO_BACKEND=QUAD
+echo "startup_static_quad QUAD: $(startup startup_static_quad)"
@@ -0,0 +1,58 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define OPS 10000
+
+/* Interpose the allocator: the backends resolve malloc to these */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static volatile long allocations = 0;
+
+void *malloc(size_t size) {
+    allocations++;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size) {
+    allocations++;
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    allocations++;
+    return __libc_realloc(ptr, size);
+}
+
+float computef(float a, float b) {
+    return (a + b) * (a - b) / b;
+}
+
+double computed(double a, double b) {
+    return (a + b) * (a - b) / b;
+}
+
+int main(int argc, char ** argv)
+{
+    int i;
+    float sf = 0;
+    double sd = 0;
+
+    /* Warm up: the first operation of a thread sets up its random stream,
+     * and its MPFR operands with the MPFR backend */
+    sf += computef(1.5f, 0.1f);
+    sd += computed(1.5, 0.1);
+
+    long before = allocations;
+    for (i = 0; i < OPS; i++) {
+        sf += computef(1.5f + i, 0.1f);
+        sd += computed(1.5 + i, 0.1);
+    }
+    long count = allocations - before;
+
+    printf("%ld allocations for %d operations (%a %a)\n", count, 8 * OPS,
+           sf, sd);
+    return count != 0;
+}
@@ -0,0 +1,19 @@
+#!/bin/bash
+
+echo "computef" > functions
+echo "computed" >> functions
+verificarlo -O0 test.c -o test --functions-file=functions
+
+export VERIFICARLO_PRECISION=40
+
+for BACKEND in QUAD MPFR; do
+    for MODE in IEEE MCA PB RR; do
+        if ! VERIFICARLO_BACKEND=$BACKEND VERIFICARLO_MCAMODE=$MODE ./test; then
+            echo "$BACKEND $MODE operations should not allocate"
+            exit 1
+        fi
+    done
+done
+
+echo "test passed"
+exit 0
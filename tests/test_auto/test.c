@@ -0,0 +1,22 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "vfcwrapper.h"
+
+float computef(float a, float b) {
+    return (a + b) * (a - b) / b;
+}
+
+double computed(double a, double b) {
+    return (a + b) * (a - b) / b;
+}
+
+int main(int argc, char ** argv)
+{
+    /* an optional argument changes the precision at runtime */
+    if (argc > 1 && vfc_set_precision_and_mode(atoi(argv[1]), MCAMODE_MCA) != 0) {
+        fprintf(stderr, "cannot set precision %s\n", argv[1]);
+        return 1;
+    }
+    printf("%a %a\n", computef(1.5f, 0.1f), computed(1.5, 0.1));
+    return 0;
+}
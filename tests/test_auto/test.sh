@@ -0,0 +1,40 @@
+#!/bin/bash
+# The AUTO backend computes each type with the fastest backend valid at
+# the virtual precision, and selects them again when the precision is
+# changed at runtime. The profile reports the backends selected.
+
+echo "computef" > functions
+echo "computed" >> functions
+verificarlo -O0 test.c -o test --functions-file=functions
+
+export VERIFICARLO_BACKEND=AUTO
+export VERIFICARLO_PROFILE=profile.json
+
+check() {
+    rm -f profile.json
+    if ! ./test $4 > /dev/null; then
+        echo "AUTO run failed at precision $1 $4"
+        exit 1
+    fi
+    f=$(grep '"float_backend"' profile.json | cut -d'"' -f 4)
+    d=$(grep '"double_backend"' profile.json | cut -d'"' -f 4)
+    if [ "$f $d" != "$2 $3" ]; then
+        echo "AUTO at precision $1 $4 selected $f $d, expected $2 $3"
+        exit 1
+    fi
+}
+
+export VERIFICARLO_MCAMODE=MCA
+for p in 20:DD:DD 30:MPFR:DD 53:MPFR:DD 55:MPFR:QUAD 60:MPFR:MPFR; do
+    IFS=: read precision f d <<< "$p"
+    VERIFICARLO_PRECISION=$precision check $precision $f $d
+done
+
+# selection at runtime
+VERIFICARLO_PRECISION=60 check 20 DD DD 20
+
+# no noise is added in IEEE mode, whatever the precision
+VERIFICARLO_MCAMODE=IEEE VERIFICARLO_PRECISION=100 check 100 DD DD
+
+echo "test passed"
+exit 0
@@ -4,9 +4,14 @@ THRESHOLD = 1
 
 import sys
 
+# compares the backend output (default out_quad) with the reference
+# (default out_mpfr)
+backend = sys.argv[1] if len(sys.argv) > 1 else "out_quad"
+reference = sys.argv[2] if len(sys.argv) > 2 else "out_mpfr"
+
 max = -1
 
-for quad, mpfr in zip(file("out_quad"), file("out_mpfr")):
+for quad, mpfr in zip(file(backend), file(reference)):
     q = float(quad)
     m = float(mpfr)
     delta = abs(q-m)
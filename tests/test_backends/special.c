@@ -0,0 +1,30 @@
+#include <float.h>
+#include <stdio.h>
+
+double add(double a, double b) { return a + b; }
+double mul(double a, double b) { return a * b; }
+double dvd(double a, double b) { return a / b; }
+float addf(float a, float b) { return a + b; }
+float mulf(float a, float b) { return a * b; }
+float dvdf(float a, float b) { return a / b; }
+
+/* overflows and divisions by zero return infinities of the native sign */
+int main(void) {
+  printf("%g\n", add(DBL_MAX, DBL_MAX));
+  printf("%g\n", mul(1e200, 1e200));
+  printf("%g\n", mul(-1e200, 1e200));
+  printf("%g\n", dvd(1.0, 0.0));
+  printf("%g\n", dvd(-1.0, 0.0));
+  printf("%g\n", addf(FLT_MAX, FLT_MAX));
+  printf("%g\n", mulf(-1e30f, 1e30f));
+  printf("%g\n", dvdf(1.0f, 0.0f));
+
+  /* zeros are not perturbed: 1/0 never changes sign, 0 op x stays 0 */
+  int perturbed = 0, i;
+  for (i = 0; i < 100; i++) {
+    perturbed += dvd(1.0, 0.0) < 0 || dvdf(1.0f, 0.0f) < 0;
+    perturbed += add(0.0, 0.0) != 0 || mul(0.0, 3.0) != 0 || mulf(0.0f, 3.0f) != 0;
+  }
+  printf("%d\n", perturbed);
+  return 0;
+}
@@ -1,6 +1,8 @@
 #!/bin/bash
 #set -e
 
+FAILED=0
+
 Check() {
     MAX_PREC=$1
     for PREC in $(seq 3 10 $MAX_PREC) ; do
@@ -8,7 +10,7 @@ Check() {
         echo "Checking at PRECISION $PREC"
         export VERIFICARLO_PRECISION=$PREC
 
-        rm -f out_mpfr out_quad out_quad.orig out_mpfr.orig
+        rm -f out_mpfr out_quad out_dd out_quad.orig out_mpfr.orig out_dd.orig
         export VERIFICARLO_BACKEND="MPFR"
         ./test > out_mpfr.orig
         cat out_mpfr.orig |grep 'TEST>' | cut -d'>' -f 2 > out_mpfr
@@ -16,13 +18,20 @@ Check() {
         export VERIFICARLO_BACKEND="QUAD"
         ./test > out_quad.orig
         cat out_quad.orig | grep 'TEST>' | cut -d'>' -f 2 > out_quad
-        
-        ./check.py
-        if [ $? -ne 0 ] ; then
-            echo "error"
-        else 
-	    echo "ok for precision $PREC"
-        fi
+
+        export VERIFICARLO_BACKEND="DD"
+        ./test > out_dd.orig
+        cat out_dd.orig | grep 'TEST>' | cut -d'>' -f 2 > out_dd
+
+        for BACKEND in out_quad out_dd ; do
+            ./check.py $BACKEND out_mpfr
+            if [ $? -ne 0 ] ; then
+                echo "error for $BACKEND at precision $PREC"
+                FAILED=1
+            else
+	        echo "ok for $BACKEND at precision $PREC"
+            fi
+        done
     done
 }
 
@@ -39,3 +48,23 @@ for op in "+" "*" "/" ; do
     verificarlo -D REAL=double -D SAMPLES=1000 -D OPERATION="$op" -O0 -lm --function operate test.c -o test
     Check 53
 done
+
+echo "Checking overflows and divisions by zero"
+verificarlo -O0 special.c -o special
+printf "inf\ninf\n-inf\ninf\n-inf\ninf\n-inf\ninf\n0\n" > special.expected
+# at low precision the noise of a zero operand would not underflow to zero
+for PREC in 53 24 ; do
+    for BACKEND in QUAD DD MPFR ; do
+        for MODE in MCA PB RR ; do
+            VERIFICARLO_PRECISION=$PREC VERIFICARLO_BACKEND=$BACKEND VERIFICARLO_MCAMODE=$MODE \
+                ./special > special.out
+            if ! diff special.out special.expected ; then
+                echo "error for $BACKEND in $MODE mode at precision $PREC"
+                exit 1
+            fi
+        done
+    done
+done
+echo "ok for overflows and divisions by zero"
+
+exit $FAILED
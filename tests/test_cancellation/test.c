@@ -0,0 +1,29 @@
+#include <stdio.h>
+
+/* no cancellation */
+double sum(int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + 0.1;
+    return s;
+}
+
+/* loses 46 bits: 100.00000000000141 - 100 */
+double cancel(double s) {
+    return s - 100;
+}
+
+/* loses 14 bits: 1.0001f - 1 */
+float fcancel(float a) {
+    return a - 1.0f;
+}
+
+int main(void) {
+    double s = sum(1000), c = 0;
+    int i;
+    for (i = 0; i < 10; i++)
+        c += cancel(s);
+    printf("%g %g\n", c, fcancel(1.0001f));
+    return 0;
+}
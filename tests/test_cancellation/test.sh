@@ -0,0 +1,32 @@
+#!/bin/bash
+# VERIFICARLO_CANCELLATION counts the bits lost by the additions and
+# subtractions of each call site and ranks the sites at exit by the
+# operations losing at least VERIFICARLO_CANCELLATION_THRESHOLD bits.
+set -e
+
+echo "sum" > functions
+echo "cancel" >> functions
+echo "fcancel" >> functions
+verificarlo -O0 test.c -o test --functions-file=functions
+
+export VERIFICARLO_MCAMODE=IEEE
+export VERIFICARLO_CANCELLATION=report
+
+./test
+cat report
+
+# cancel, then fcancel, then sum which loses no bit
+grep -v "^#" report | awk '{ print $4 }' > sites
+functions=$(addr2line -f -e test $(cat sites) | sed -n '1~2p' | tr '\n' ' ')
+if [ "$functions" != "cancel fcancel sum " ]; then
+    echo "sites ranked as $functions"
+    exit 1
+fi
+grep -v "^#" report | awk 'NR == 1 { if ($1 != 10 || $2 != 10 || $3 != 46) exit 1 }
+                           NR == 2 { if ($1 != 1 || $2 != 1 || $3 != 14) exit 1 }
+                           NR == 3 { if ($1 != 0 || $2 != 1000 || $3 != 0) exit 1 }'
+
+# above the threshold, no operation is counted as a cancellation
+VERIFICARLO_CANCELLATION_THRESHOLD=50 ./test > /dev/null
+grep -q "at least 50 bits" report
+grep -v "^#" report | awk '{ if ($1 != 0) exit 1 }'
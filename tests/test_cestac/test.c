@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include "vfcwrapper.h"
+
+#define N 100000
+
+double dsum(int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + 0.1;
+    return s;
+}
+
+float fsum(int n) {
+    float s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + 0.1f;
+    return s;
+}
+
+double dcancel(double s) {
+    return s - 10000.0;
+}
+
+float fcancel(float s) {
+    return s - 10000.0f;
+}
+
+int main(void)
+{
+    double d = dsum(N);
+    float f = fsum(N);
+    printf("%.2f %.2f %.2f %.2f\n", vfc_digits(d), vfc_digits(dcancel(d)),
+           vfc_digitsf(f), vfc_digitsf(fcancel(f)));
+    return 0;
+}
@@ -0,0 +1,31 @@
+#!/bin/bash
+# The CESTAC backend estimates the significant digits of a sum of 0.1 in
+# a single run: about 13 digits in double and 5 in float, of which
+# subtracting 10000 cancels all but 1 or 2. In IEEE mode the samples are
+# equal and every value has the digits of its type.
+
+verificarlo -O0 test.c -o test
+
+export VERIFICARLO_BACKEND=CESTAC
+
+export VERIFICARLO_MCAMODE=IEEE
+r=$(./test)
+if [ "$r" != "15.95 15.95 7.22 7.22" ]; then
+    echo "IEEE digits $r should be exact"
+    exit 1
+fi
+
+for MODE in RR MCA; do
+    export VERIFICARLO_MCAMODE=$MODE
+    for i in $(seq 1 5); do
+        r=$(VERIFICARLO_SEED=$i ./test)
+        if ! echo $r | awk '{ exit ($1 > 11 && $1 < 15.5 && $2 < 4 &&
+                                     $3 > 3 && $3 < 7 && $4 < 4) ? 0 : 1 }'; then
+            echo "$MODE digits $r out of the expected ranges"
+            exit 1
+        fi
+    done
+done
+
+echo "test passed"
+exit 0
@@ -0,0 +1,42 @@
+#include <stdio.h>
+
+double triple(double x) {
+    return x * 3.0;
+}
+
+double shift(double x) {
+    return x + 0.5;
+}
+
+double seventh(double x) {
+    return x / 7.0;
+}
+
+/* cancels about 10 of the 16 digits */
+double difference(double x) {
+    return (x + 1e-10) - x;
+}
+
+double square(double x) {
+    return x * x;
+}
+
+double twice(double x) {
+    return x + x;
+}
+
+double inverse(double x) {
+    return 1.0 / x;
+}
+
+double tenth(double x) {
+    return x * 0.1;
+}
+
+int main(void)
+{
+    double x = 1.0;
+    printf("%.17g\n", tenth(inverse(twice(square(seventh(shift(triple(x))))))));
+    printf("%.17g\n", difference(x));
+    return 0;
+}
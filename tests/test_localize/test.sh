@@ -0,0 +1,20 @@
+#!/bin/bash
+# vfc-localize.py finds the function losing digits among the functions of
+# a binary instrumented once, each subset is selected with VERIFICARLO_SCOPE.
+
+set -e
+
+verificarlo -O0 test.c -o test
+
+printf "triple\nshift\nseventh\ndifference\nsquare\ntwice\ninverse\ntenth\n" > functions
+../../postprocess/vfc-localize.py --functions functions --digits 10 --samples 8 --jobs 4 \
+    --output found -- ./test
+
+if [ "$(grep -v '^#' found)" != "difference" ]; then
+    echo "unexpected functions found:"
+    cat found
+    exit 1
+fi
+
+echo "test passed"
+exit 0
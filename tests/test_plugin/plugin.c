@@ -0,0 +1,73 @@
+/* Out of tree backend plugin: computes the operations natively and
+ * counts the calls to its scalar and vector entries, which it prints at
+ * teardown. The vector capability is withdrawn when PLUGIN_SCALAR is set. */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vfcwrapper.h"
+
+static unsigned long scalar_calls, vector_calls;
+
+static void _seed(const struct vfc_rng_config_t *config) {}
+static int _set_mode(int mode) { return 0; }
+static int _set_precision(int precision) { return 0; }
+
+static float _floatadd(float a, float b) { scalar_calls++; return a + b; }
+static float _floatsub(float a, float b) { scalar_calls++; return a - b; }
+static float _floatmul(float a, float b) { scalar_calls++; return a * b; }
+static float _floatdiv(float a, float b) { scalar_calls++; return a / b; }
+static double _doubleadd(double a, double b) { scalar_calls++; return a + b; }
+static double _doublesub(double a, double b) { scalar_calls++; return a - b; }
+static double _doublemul(double a, double b) { scalar_calls++; return a * b; }
+static double _doublediv(double a, double b) { scalar_calls++; return a / b; }
+
+#define VECTOR(op, sym)                                                 \
+    static void _float##op##_vector(int n, float *c, const float *a,    \
+                                    const float *b) {                   \
+        int i;                                                          \
+        vector_calls++;                                                 \
+        for (i = 0; i < n; i++)                                         \
+            c[i] = a[i] sym b[i];                                       \
+    }
+
+VECTOR(add, +)
+VECTOR(sub, -)
+VECTOR(mul, *)
+VECTOR(div, /)
+
+extern struct vfc_plugin_t vfc_plugin;
+
+static int _init(void) {
+    if (getenv("PLUGIN_SCALAR") != NULL)
+        vfc_plugin.caps &= ~VFC_PLUGIN_CAP_VECTOR;
+    return 0;
+}
+
+static void _teardown(void) {
+    printf("scalar %lu vector %lu\n", scalar_calls, vector_calls);
+}
+
+struct vfc_plugin_t vfc_plugin = {
+    sizeof(struct vfc_plugin_t),
+    VFC_PLUGIN_VERSION,
+    VFC_PLUGIN_CAP_VECTOR,
+    "counter",
+    _init,
+    _teardown,
+    _seed,
+    _set_mode,
+    _set_precision,
+    _floatadd,
+    _floatsub,
+    _floatmul,
+    _floatdiv,
+    _doubleadd,
+    _doublesub,
+    _doublemul,
+    _doublediv,
+    _floatadd_vector,
+    _floatsub_vector,
+    _floatmul_vector,
+    _floatdiv_vector,
+};
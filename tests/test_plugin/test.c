@@ -0,0 +1,17 @@
+#include <stdio.h>
+
+typedef float float4 __attribute__((ext_vector_type(4)));
+
+/* 3 scalar operations and 1 vector operation of 4 lanes */
+void compute(double * x, float4 * y) {
+    x[0] = x[0] * x[1] + x[1] / x[0];
+    y[0] = y[0] + y[1];
+}
+
+int main(void) {
+    double x[2] = { 3, 7 };
+    float4 y[2] = { { 1, 2, 3, 4 }, { 4, 3, 2, 1 } };
+    compute(x, y);
+    printf("%.17g %g %g %g %g\n", x[0], y[0][0], y[0][1], y[0][2], y[0][3]);
+    return 0;
+}
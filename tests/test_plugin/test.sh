@@ -0,0 +1,38 @@
+#!/bin/bash
+# A backend built out of tree is loaded from VERIFICARLO_BACKEND_PLUGIN.
+# The plugin counts the calls to its entries: vector operations go to its
+# vector entry, or lane by lane to the scalar entries when it does not
+# advertise the vector capability.
+set -e
+
+${CC:-cc} -shared -fPIC -I../../src/vfcwrapper plugin.c -o libplugin.so
+verificarlo -O0 test.c -o test --function=compute
+
+export VERIFICARLO_BACKEND_PLUGIN=$PWD/libplugin.so
+
+check() {
+    ./test > output
+    cat output
+    if [ "$(head -1 output)" != "23.333333333333332 5 5 5 5" ]; then
+        echo "wrong results"
+        exit 1
+    fi
+    if [ "$(tail -1 output)" != "$1" ]; then
+        echo "expected $1 calls"
+        exit 1
+    fi
+}
+
+# the plugin is selected when VERIFICARLO_BACKEND is not set
+check "scalar 3 vector 1"
+VERIFICARLO_BACKEND=PLUGIN PLUGIN_SCALAR=1 check "scalar 7 vector 0"
+
+# the profiling hooks count the vector lanes on the scalar entries
+VERIFICARLO_PROFILE=profile.json check "scalar 7 vector 0"
+grep -q '"plugin": "counter"' profile.json
+
+# the plugin library is required
+if env -u VERIFICARLO_BACKEND_PLUGIN VERIFICARLO_BACKEND=PLUGIN ./test 2> /dev/null; then
+    echo "PLUGIN backend loaded without a library"
+    exit 1
+fi
@@ -0,0 +1,31 @@
+#include <signal.h>
+#include <stdio.h>
+#include "vfcwrapper.h"
+
+#define N 100
+
+double sum(int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + 0.1;
+    return s;
+}
+
+int main (int argc, char * argv[])
+{
+    double v[2];
+    v[0] = sum(N);
+    v[1] = 1.0;
+    vfc_probe("sum", v[0]);
+    vfc_probe_array("v", v, 2);
+
+    /* names that do not fit in the store are ignored, not truncated */
+    vfc_probe("long_name_0123456789012345678901234567890123456789012345678_a", 1.0);
+    vfc_probe("long_name_0123456789012345678901234567890123456789012345678_b", 2.0);
+
+    /* a killed sample keeps the probes it recorded */
+    if (argc > 1)
+        raise(SIGKILL);
+    return 0;
+}
@@ -0,0 +1,34 @@
+#!/bin/bash
+set -e
+
+verificarlo -O0 test.c -o test --function=sum
+
+export VERIFICARLO_PRECISION=30
+export VERIFICARLO_PROBE_FILE=$PWD/probes
+rm -f probes
+
+# Run the samples concurrently, they all accumulate in the same store.
+# One in three is killed after recording its probes.
+for i in $(seq 30); do
+    if [ $((i % 3)) -eq 0 ]; then
+        (./test kill || true) 2> /dev/null &
+    else
+        ./test 2> log.$i &
+    fi
+done
+wait
+
+../../postprocess/vfc-probes.py probes > report
+cat report
+
+# 30 samples, the noisy sum keeps about 9 significant digits, the
+# constant is exact
+grep -q "^# 30 samples" report
+awk '$1 == "sum" || $1 == "v[0]" { if ($2 != 30 || $5 < 7 || $5 > 11) exit 1 }
+     $1 == "v[1]" { if ($5 != "inf") exit 1 }' report
+
+# the names too long are ignored with a warning
+grep -q "Probe name longer than 59 characters" log.1
+if grep -q "^long_name" report; then
+    exit 1
+fi
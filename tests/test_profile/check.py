@@ -0,0 +1,22 @@
+#!/usr/bin/env python
+
+import json
+import sys
+
+profile = json.load(open("profile.json"))
+ops = profile["operations"]
+
+expected = {("double", "add"): 1000, ("float", "div"): 1}
+
+for t in ops:
+    for o in ops[t]:
+        calls = ops[t][o]["calls"]
+        if calls != expected.get((t, o), 0):
+            print("ERROR: %s %s calls = %d" % (t, o, calls))
+            sys.exit(1)
+
+if ops["double"]["add"]["sampled"] == 0:
+    print("ERROR: double add was never timed")
+    sys.exit(1)
+
+sys.exit(0)
@@ -0,0 +1,24 @@
+#include<stdio.h>
+
+#define N 1000
+
+double sum(double * a, int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + a[i];
+    return s;
+}
+
+float scale(float a) {
+    return a / 3.0f;
+}
+
+int main (void)
+{
+    double a[N];
+    int i;
+    for (i = 0; i < N; i++)
+        a[i] = i;
+    printf("%g %g\n", sum(a, N), scale(1.0f));
+}
@@ -0,0 +1,16 @@
+#!/bin/bash
+set -e
+
+echo "sum" > functions
+echo "scale" >> functions
+verificarlo -O0 test.c -o test --functions-file=functions
+
+export VERIFICARLO_PROFILE=profile.json
+export VERIFICARLO_PROFILE_PERIOD=8
+
+for BACKEND in MPFR QUAD; do
+    export VERIFICARLO_BACKEND=$BACKEND
+    rm -f profile.json
+    ./test
+    ./check.py
+done
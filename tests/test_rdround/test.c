@@ -0,0 +1,16 @@
+#include <stdio.h>
+
+/* 0.1f is not exact: with rounding to nearest the sum drifts away from
+ * n / 10, random rounding keeps it unbiased */
+float accumulate(float x, int n) {
+    float s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + x;
+    return s;
+}
+
+int main(int argc, char ** argv) {
+    printf("%.6f\n", accumulate(0.1f, 1000000));
+    return 0;
+}
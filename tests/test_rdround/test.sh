@@ -0,0 +1,33 @@
+#!/bin/bash
+# The RDROUND backend rounds each result up or down with a probability
+# proportional to its rounding error: one million float additions of 0.1
+# stay within 1e-3 of 100000, where rounding to nearest is 1% off.
+
+verificarlo -O0 test.c -o test --function=accumulate
+
+export VERIFICARLO_BACKEND=RDROUND
+
+check() {
+    awk -v s=$1 'BEGIN { e = (s - 100000) / 100000; exit (e < 1e-3 && e > -1e-3) ? 0 : 1 }'
+}
+
+export VERIFICARLO_MCAMODE=IEEE
+s=$(./test)
+if check $s; then
+    echo "IEEE sum $s should be biased"
+    exit 1
+fi
+
+for MODE in RR MCA; do
+    export VERIFICARLO_MCAMODE=$MODE
+    for i in $(seq 1 5); do
+        s=$(./test)
+        if ! check $s; then
+            echo "$MODE sum $s should be within 1e-3 of 100000"
+            exit 1
+        fi
+    done
+done
+
+echo "test passed"
+exit 0
@@ -0,0 +1,31 @@
+#include <assert.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+
+double compute(double z) {
+    return z / 3.0 + z / 7.0;
+}
+
+static void set_control(const char * path, const char * config) {
+    FILE * f = fopen(path, "w");
+    assert(f != NULL);
+    fputs(config, f);
+    fclose(f);
+}
+
+int main (int argc, char ** argv)
+{
+    assert(argc == 2);
+    int i;
+
+    /* Starts in MCA mode */
+    for (i = 0; i < 2; i++)
+        printf("%a\n", compute(1.0));
+
+    /* Switch to IEEE mode and wait for the polling thread */
+    set_control(argv[1], "VERIFICARLO_MCAMODE=IEEE\n");
+    sleep(1);
+    for (i = 0; i < 2; i++)
+        fprintf(stderr, "%a\n", compute(1.0));
+}
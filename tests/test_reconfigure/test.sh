@@ -0,0 +1,23 @@
+#!/bin/bash
+
+verificarlo test.c -o test --function=compute
+
+export VERIFICARLO_PRECISION=40
+export VERIFICARLO_CONTROL_FILE=$PWD/control
+export VERIFICARLO_CONTROL_POLL=10
+
+echo "VERIFICARLO_MCAMODE=MCA" > control
+./test control > output_mca 2> output_ieee
+
+if [ $(sort -u output_mca | wc -l) -ne 2 ] ; then
+    echo "MCA outputs should differ"
+    exit 1
+fi
+
+if [ $(sort -u output_ieee | wc -l) -ne 1 ] ; then
+    echo "IEEE outputs should be the same"
+    exit 1
+fi
+
+echo "test passed"
+exit 0
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include "vfcwrapper.h"
+
+#define N 100000
+
+/* sums 0.1 n times in single precision */
+float fsum(int n) {
+    float s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + 0.1f;
+    return s;
+}
+
+/* Muller's recurrence converges to 6 in exact arithmetic and to 100 in
+ * floating point */
+double muller(int n) {
+    double u0 = 2, u1 = -4, u2;
+    int i;
+    for (i = 0; i < n; i++) {
+        u2 = 111 - 1130 / u1 + 3000 / (u0 * u1);
+        u0 = u1;
+        u1 = u2;
+    }
+    return u1;
+}
+
+/* called with the constants 10000 and 10001 */
+float difference(float a, float b) {
+    return a - b;
+}
+
+int main (void)
+{
+    vfc_probe("fsum", fsum(N));
+    /* 10000 is also the rounding of fsum, in REF mode it takes the high
+     * precision value of fsum from the shadow cache */
+    vfc_probe("aliased", difference(10000.0f, 10001.0f));
+    vfc_probe("muller", muller(25));
+    vfc_probe("one", 1.0);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#!/bin/bash
+set -e
+
+verificarlo -O0 test.c -o test
+
+export VERIFICARLO_BACKEND=MPFR
+rm -f ieee ref
+
+# The reference run carries 200 bits through the whole computation
+VERIFICARLO_MCAMODE=REF VERIFICARLO_PRECISION=200 VERIFICARLO_PROBE_FILE=$PWD/ref ./test
+VERIFICARLO_MCAMODE=IEEE VERIFICARLO_PROBE_FILE=$PWD/ieee ./test
+
+../../postprocess/vfc-probes.py ieee --reference ref > report
+cat report
+
+# the reference sum is exactly 10000 and the recurrence reaches 6, the
+# float sum keeps less than four digits and the IEEE recurrence has no
+# correct digit; the constant is exact
+awk '$1 == "fsum" { if ($4 != "1.0000000000000000e+04" || $6 < 3 || $6 > 4) exit 1 }
+     $1 == "muller" { if ($4 < 6 || $4 > 6.1 || $6 != "0.00") exit 1 }
+     $1 == "one" { if ($6 != "inf") exit 1 }' report
+
+# the constant 10000 collides with the rounding of fsum, whose high
+# precision value is 10000.000149: the reference of 10000 - 10001 is
+# -0.999851 while IEEE gives the exact -1 (see the REF mode in README)
+awk '$1 == "aliased" { if ($3 != "-1.0000000000000000e+00" || $4 < -0.99986 || $4 > -0.99984) exit 1 }' report
+
+# the reference must be at least as precise as the doubles
+if VERIFICARLO_MCAMODE=REF VERIFICARLO_PRECISION=30 ./test 2> err; then
+    echo "REF mode accepted at precision 30"
+    exit 1
+fi
+grep -q "REF mode requires a precision of at least 53 bits" err
+
+# The REF mode is only offered by MPFR, AUTO selects it
+if VERIFICARLO_BACKEND=QUAD VERIFICARLO_MCAMODE=REF ./test 2> err; then
+    echo "REF mode accepted by QUAD"
+    exit 1
+fi
+grep -q "REF mode is only available with the MPFR backend" err
+VERIFICARLO_BACKEND=AUTO VERIFICARLO_MCAMODE=REF VERIFICARLO_PRECISION=200 ./test
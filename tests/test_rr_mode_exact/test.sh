@@ -8,7 +8,7 @@ export VERIFICARLO_MCAMODE=RR
 
 verificarlo -O0 rr_mode.c -o rr_mode
 
-for BACKEND in MPFR QUAD; do
+for BACKEND in MPFR QUAD RDROUND; do
     export VERIFICARLO_BACKEND=$BACKEND
     rm -f output_$BACKEND
     for i in `seq 100`; do
@@ -24,7 +24,7 @@ export VERIFICARLO_MCAMODE=RR
 
 verificarlo -DDOUBLE -O0 rr_mode.c -o rr_mode
 
-for BACKEND in MPFR QUAD; do
+for BACKEND in MPFR QUAD RDROUND; do
     export VERIFICARLO_BACKEND=$BACKEND
     rm -f output_$BACKEND
     for i in `seq 100`; do
@@ -0,0 +1,14 @@
+#include <stdio.h>
+
+double compute(double z) {
+    return z / 3.0 + z / 7.0;
+}
+
+int main (int argc, char ** argv)
+{
+    int i;
+    double r = 1.0;
+    for (i = 0; i < 100; i++)
+        r = compute(r + 1.0);
+    printf("%a\n", r);
+}
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+verificarlo test.c -o test --function=compute
+verificarlo threads.c -o threads --function=compute -lpthread
+
+export VERIFICARLO_PRECISION=30
+export VERIFICARLO_SEED=42
+
+for BACKEND in QUAD MPFR; do
+    for RNG in TINYMT PHILOX XOSHIRO; do
+        export VERIFICARLO_BACKEND=$BACKEND
+        export VERIFICARLO_RNG=$RNG
+        rm -f output_same output_samples
+        for i in $(seq 1 10); do
+            VERIFICARLO_SAMPLE=1 ./test >> output_same
+            VERIFICARLO_SAMPLE=$i ./test >> output_samples
+        done
+
+        if [ $(sort -u output_same | wc -l) -ne 1 ] ; then
+            echo "$BACKEND $RNG: a seeded sample should be reproducible"
+            exit 1
+        fi
+
+        if [ $(sort -u output_samples | wc -l) -lt 2 ] ; then
+            echo "$BACKEND $RNG: different samples should differ"
+            exit 1
+        fi
+
+        # the buffer size does not change the values drawn
+        rm -f output_buffers
+        for BUFFER in 1 3 64 1024; do
+            VERIFICARLO_SAMPLE=1 VERIFICARLO_RNG_BUFFER=$BUFFER ./test >> output_buffers
+        done
+
+        if [ $(cat output_same output_buffers | sort -u | wc -l) -ne 1 ] ; then
+            echo "$BACKEND $RNG: results should not depend on the buffer size"
+            exit 1
+        fi
+
+        # a thread with an assigned id replays its stream whatever the
+        # order in which the threads start drawing
+        rm -f output_threads
+        VERIFICARLO_SAMPLE=1 ./threads 01 >> output_threads
+        VERIFICARLO_SAMPLE=1 ./threads 10 >> output_threads
+
+        if [ $(sort -u output_threads | wc -l) -ne 1 ] ; then
+            echo "$BACKEND $RNG: a thread should replay the stream of its id"
+            exit 1
+        fi
+        if [ $(sort -u output_threads | awk '$1 == $2' | wc -l) -ne 0 ] ; then
+            echo "$BACKEND $RNG: threads with different ids should differ"
+            exit 1
+        fi
+    done
+done
+
+echo "test passed"
+exit 0
@@ -0,0 +1,42 @@
+#include <pthread.h>
+#include <stdio.h>
+#include "vfcwrapper.h"
+
+double compute(double z) {
+    return z / 3.0 + z / 7.0;
+}
+
+static double result[2];
+
+static void * worker(void * arg) {
+    int id = *(int *) arg;
+    int i;
+    double r = 1.0;
+
+    /* the stream of the thread depends on its id, not on the order in
+     * which the threads draw their first random number */
+    vfc_rng_set_thread(id);
+    for (i = 0; i < 100; i++)
+        r = compute(r + 1.0);
+    result[id] = r;
+    return NULL;
+}
+
+/* runs the threads one after the other, in the order given by argv[1] */
+int main (int argc, char ** argv)
+{
+    int ids[2] = { 0, 1 };
+    pthread_t t;
+    int i;
+
+    if (argc > 1 && argv[1][0] == '1') {
+        ids[0] = 1;
+        ids[1] = 0;
+    }
+    for (i = 0; i < 2; i++) {
+        pthread_create(&t, NULL, worker, &ids[i]);
+        pthread_join(t, NULL);
+    }
+    printf("%a %a\n", result[0], result[1]);
+    return 0;
+}
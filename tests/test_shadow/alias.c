@@ -0,0 +1,21 @@
+#include <stdio.h>
+#include "vfcwrapper.h"
+
+/* called with 1e16 and 0.5, the result rounds to 1e16 */
+double offset(double a, double b) {
+    return a + b;
+}
+
+/* called with the constants 1e16 and 1e16 - 2, exact */
+double aliased(double a, double b) {
+    return a - b;
+}
+
+int main(void) {
+    double x = offset(1e16, 0.5);
+    /* 1e16 is also the rounding of x, it takes the shadow 1e16 + 0.5 of
+     * x from the shadow cache */
+    double d = aliased(1e16, 1e16 - 2);
+    printf("%.17g %.17g %.2f\n", x, d, vfc_digits(d));
+    return 0;
+}
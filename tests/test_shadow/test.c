@@ -0,0 +1,28 @@
+#include <stdio.h>
+#include "vfcwrapper.h"
+
+/* accurate to about 13 digits */
+double sum(int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s = s + 0.1;
+    return s;
+}
+
+/* loses all the digits of s - 10000 */
+double cancel(double s) {
+    return s - 10000;
+}
+
+/* exact */
+double scale(double s) {
+    return s * 2;
+}
+
+int main(void) {
+    double s = sum(100000);
+    double c = scale(cancel(s));
+    printf("%.17g %.17g %.2f %.2f\n", s, c, vfc_digits(s), vfc_digits(c));
+    return 0;
+}
@@ -0,0 +1,53 @@
+#!/bin/bash
+# The SHADOW backend computes the native results and ranks the call sites
+# by the largest error they introduce: the cancellation loses every digit,
+# the sum a few, the product none.
+set -e
+
+verificarlo -O0 test.c -o test
+
+export VERIFICARLO_BACKEND=SHADOW
+export VERIFICARLO_SHADOW_REPORT=report
+
+./test > output
+cat output report
+
+# native results, digits against the shadows
+if [ "$(cut -d' ' -f1,2 output)" != "10000.000000018848 3.769673639908433e-08" ]; then
+    echo "results are not native"
+    exit 1
+fi
+awk '{ if ($3 < 11 || $3 > 13 || $4 != "0.00") exit 1 }' output
+
+# sites, in the order cancel, sum, scale
+grep -v "^#" report | awk '{ print $2 }' > sites
+functions=$(addr2line -f -e test $(cat sites) | sed -n '1~2p' | tr '\n' ' ')
+if [ "$functions" != "cancel sum scale " ]; then
+    echo "sites ranked as $functions"
+    exit 1
+fi
+grep -v "^#" report | awk 'NR == 1 { if ($1 < 0.5 || $3 != 1) exit 1 }
+                           NR == 2 { if ($1 > 1e-15 || $3 != 100000) exit 1 }
+                           NR == 3 { if ($1 != 0) exit 1 }'
+
+# the profiling hooks in front of the backend keep the sites
+VERIFICARLO_PROFILE=profile.json ./test > /dev/null
+grep -v "^#" report | awk '{ print $2 }' > sites
+functions=$(addr2line -f -e test $(cat sites) | sed -n '1~2p' | tr '\n' ' ')
+if [ "$functions" != "cancel sum scale " ]; then
+    echo "profiled sites ranked as $functions"
+    exit 1
+fi
+
+# the constant 1e16 collides with the rounding of 1e16 + 0.5 and takes
+# its shadow: the exact 1e16 - (1e16 - 2) reports a local error of 0.2
+# (see the SHADOW backend in README)
+verificarlo -O0 alias.c -o alias
+./alias > /dev/null
+grep -v "^#" report | awk '{ print $1, $2 }' > sites
+function=$(addr2line -f -e alias $(head -1 sites | cut -d' ' -f2) | head -1)
+error=$(head -1 sites | cut -d' ' -f1)
+if [ "$function" != "aliased" ] || ! awk -v e=$error 'BEGIN { exit !(e > 0.19 && e < 0.21) }'; then
+    echo "aliased site reported as $function with error $error"
+    exit 1
+fi
@@ -0,0 +1,22 @@
+#include <stdio.h>
+
+double sum(int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s += 0.1;
+    return s;
+}
+
+/* loses 46 bits */
+double cancel(double s) {
+    return s - 100;
+}
+
+int main(void)
+{
+    double s = sum(1000);
+    printf("%.17g\n", s);
+    printf("%.17g\n", cancel(s));
+    return 0;
+}
@@ -0,0 +1,45 @@
+#!/bin/bash
+# A cancellation report of a profiling build is converted into a site
+# profile, and the pass only instruments the sites of the profile losing
+# at least the threshold bits, the others are computed natively.
+
+set -e
+
+verificarlo -O0 -g test.c -o profiling
+VERIFICARLO_MCAMODE=IEEE VERIFICARLO_CANCELLATION=report ./profiling > /dev/null
+../../postprocess/vfc-profile.py report --output profile
+
+# profile lines: function file:line calls cancelled max_bits
+if [ "$(grep -v '^#' profile | awk '{print $1, $3, $5}' | tr '\n' ' ')" != "cancel 1 46 sum 1000 0 " ]; then
+    echo "unexpected profile:"
+    cat profile
+    exit 1
+fi
+if ! grep -v '^#' profile | head -1 | grep -q "^cancel *[^ ]*test.c:14 "; then
+    echo "cancel is not located at test.c:14"
+    exit 1
+fi
+
+verificarlo -O0 test.c -o test --site-profile=profile --site-threshold=20
+./test > output1
+./test > output2
+if [ "$(head -1 output1)" != "$(head -1 output2)" ]; then
+    echo "sum is instrumented"
+    exit 1
+fi
+if [ "$(tail -1 output1)" == "$(tail -1 output2)" ]; then
+    echo "cancel is not instrumented"
+    exit 1
+fi
+
+# a profile is also a functions file
+verificarlo -O0 test.c -o test --functions-file=profile
+./test > output1
+./test > output2
+if [ "$(head -1 output1)" == "$(head -1 output2)" ]; then
+    echo "sum is not instrumented with the profile as functions file"
+    exit 1
+fi
+
+echo "test passed"
+exit 0
@@ -0,0 +1,35 @@
+#include <stdio.h>
+
+double scale(double x) {
+    return x * 3.0 / 3.0;
+}
+
+double accumulate(int n) {
+    double s = 0;
+    int i;
+    for (i = 0; i < n; i++)
+        s += 1e-4;
+    return s;
+}
+
+double square(double x) {
+    return x * x;
+}
+
+double half(double x) {
+    return x * 0.5;
+}
+
+/* loses every bit of the offset below 24 bits */
+double offset(double x) {
+    return (x + 1e-9) - x;
+}
+
+int main(void)
+{
+    printf("scale %.17g\n", scale(0.1));
+    printf("accumulate %.17g\n", accumulate(10000));
+    printf("square %.17g half %.17g\n", square(1.1), half(0.3));
+    printf("offset %.17g\n", offset(1.0));
+    return 0;
+}
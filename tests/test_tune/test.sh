@@ -0,0 +1,47 @@
+#!/bin/bash
+# VERIFICARLO_SCOPE restricts the backend to the functions it lists and
+# rounds their results to an optional precision. vfc-tune.py searches the
+# functions which can be rounded to float precision without losing the
+# digits of the outputs.
+
+set -e
+
+verificarlo -O0 test.c -o test
+
+# the functions out of the scope are computed natively, even in MCA mode
+VERIFICARLO_MCAMODE=IEEE ./test > native
+echo "accumulate" > scope
+for i in 1 2; do
+    VERIFICARLO_SCOPE=scope ./test > scoped$i
+done
+if [ "$(grep -v accumulate scoped1)" != "$(grep -v accumulate native)" ]; then
+    echo "functions out of the scope are not computed natively"
+    exit 1
+fi
+if diff scoped1 scoped2 > /dev/null; then
+    echo "functions in the scope are not computed by the backend"
+    exit 1
+fi
+
+# a precision rounds the results of the function
+echo "scale 24" > scope
+VERIFICARLO_MCAMODE=IEEE VERIFICARLO_SCOPE=scope ./test > rounded
+if [ "$(grep scale rounded)" != "scale 0.10000000149011612" ]; then
+    echo "scale is not rounded to 24 bits: $(grep scale rounded)"
+    exit 1
+fi
+
+printf "scale\naccumulate\nsquare\nhalf\noffset\n" > candidates
+../../postprocess/vfc-tune.py --candidates candidates --digits 6 --jobs 4 --output map -- ./test
+if [ "$(grep -v '^#' map | tr '\n' ' ')" != "scale 24 square 24 half 24 " ]; then
+    echo "unexpected precision map:"
+    cat map
+    exit 1
+fi
+
+# the map is a scope which meets the criterion
+VERIFICARLO_MCAMODE=IEEE VERIFICARLO_SCOPE=map ./test > tuned
+grep -q "accumulate $(grep accumulate native | cut -d' ' -f2)" tuned
+
+echo "test passed"
+exit 0
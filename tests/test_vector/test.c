@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <string.h>
+
+typedef float float2 __attribute__((ext_vector_type(2)));
+typedef float float4 __attribute__((ext_vector_type(4)));
+typedef float float8 __attribute__((ext_vector_type(8)));
+typedef float float16 __attribute__((ext_vector_type(16)));
+
+/* c = a op b on the first size lanes, with a vector operation or, when
+ * SCALAR is defined, lane by lane */
+#ifdef SCALAR
+#define OP(size, op, c, a, b) {                 \
+        int l;                                  \
+        for (l = 0; l < size; l++)              \
+            c[l] = a[l] op b[l];                \
+    }
+#else
+#define OP(size, op, c, a, b) {                 \
+        float##size va, vb, vc;                 \
+        memcpy(&va, a, sizeof(va));             \
+        memcpy(&vb, b, sizeof(vb));             \
+        vc = va op vb;                          \
+        memcpy(c, &vc, sizeof(vc));             \
+    }
+#endif
+
+void compute(float * x, float * y) {
+    OP(16, *, x, x, y);
+    OP(16, /, x, x, y);
+    OP(16, +, x, x, y);
+    OP(16, -, x, x, y);
+    OP(8, *, y, y, x);
+    OP(8, /, y, y, x);
+    OP(4, +, y, y, x);
+    OP(2, -, y, y, x);
+}
+
+int main(int argc, char ** argv) {
+    float x[16], y[16];
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        x[i] = 1.0f + i / 7.0f;
+        y[i] = 0.5f + i / 13.0f;
+    }
+    for (i = 0; i < 100; i++)
+        compute(x, y);
+    for (i = 0; i < 16; i++)
+        printf("%a %a\n", x[i], y[i]);
+}
@@ -0,0 +1,26 @@
+#!/bin/bash
+# Float vector operations are computed by the vector kernels of the
+# backend when it has some: for a given seed they must give the results
+# of the same operations performed lane by lane.
+
+verificarlo -O0 test.c -o test_vector --function=compute
+verificarlo -O0 -DSCALAR test.c -o test_scalar --function=compute
+
+export VERIFICARLO_PRECISION=20
+export VERIFICARLO_SEED=42
+
+for BACKEND in QUAD MPFR; do
+    for MODE in IEEE MCA PB RR; do
+        export VERIFICARLO_BACKEND=$BACKEND
+        export VERIFICARLO_MCAMODE=$MODE
+        ./test_vector > output_vector
+        ./test_scalar > output_scalar
+        if ! diff output_vector output_scalar > /dev/null; then
+            echo "$BACKEND $MODE: vector and scalar results differ"
+            exit 1
+        fi
+    done
+done
+
+echo "test passed"
+exit 0
@@ -0,0 +1,14 @@
+#include <stdio.h>
+
+double ddiv(double a, double b) {
+    return a / b;
+}
+
+float fdiv(float a, float b) {
+    return a / b;
+}
+
+int main(int argc, char ** argv) {
+    printf("%a %a\n", ddiv(1.0, 3.0), (double) fdiv(1.0f, 3.0f));
+    return 0;
+}
@@ -0,0 +1,40 @@
+#!/bin/bash
+# The VPREC backend rounds 1/3 = 0x1.5555...p-2 to the virtual precision:
+# at 10 bits 0x1.558p-2 to nearest, 0x1.55p-2 toward zero, and one of
+# them when rounding randomly.
+
+verificarlo -O0 test.c -o test
+
+export VERIFICARLO_BACKEND=VPREC
+export VERIFICARLO_MCAMODE=RR
+
+check() {
+    r=$(VERIFICARLO_VPREC_ROUNDING=$1 VERIFICARLO_PRECISION=$2 ./test)
+    if [ "$r" != "$3" ]; then
+        echo "$1 at $2 bits: $r, expected $3"
+        exit 1
+    fi
+}
+
+check NEAREST 10 "0x1.558p-2 0x1.558p-2"
+check ZERO 10 "0x1.55p-2 0x1.55p-2"
+check NEAREST 24 "0x1.555556p-2 0x1.555556p-2"
+check NEAREST 53 "0x1.5555555555555p-2 0x1.555556p-2"
+
+rm -f output_random
+for i in $(seq 1 20); do
+    VERIFICARLO_SEED=$i VERIFICARLO_VPREC_ROUNDING=RANDOM VERIFICARLO_PRECISION=10 ./test >> output_random
+done
+
+if grep -v -E "^0x1.55(8)?p-2 0x1.55(8)?p-2$" output_random; then
+    echo "RANDOM rounding should round up or down"
+    exit 1
+fi
+
+if [ $(sort -u output_random | wc -l) -lt 2 ]; then
+    echo "RANDOM rounding should not be deterministic"
+    exit 1
+fi
+
+echo "test passed"
+exit 0